@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    CoefficientBank.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientBank.h"
+
+namespace
+{
+    //juce gives us b0 b1 b2 a0 a1 a2, this divides through by a0 the same way IIR::Coefficients does
+    BiquadCoefficients normalise(const std::array<double, 6>& raw)
+    {
+        auto a0inv = 1.0 / raw[3];
+        return { raw[0] * a0inv, raw[1] * a0inv, raw[2] * a0inv, raw[4] * a0inv, raw[5] * a0inv };
+    }
+
+    BiquadCoefficients makePeak(double sampleRate, float freq, float q, float gainDecibels)
+    {
+        return normalise(juce::dsp::IIR::ArrayCoefficients<double>::makePeakFilter(sampleRate, freq, q, juce::Decibels::decibelsToGain((double) gainDecibels)));
+    }
+
+    //butterworth of order 2 * numSections, the same sections designIIRHighpassHighOrderButterworthMethod gives
+    CutCoefficients makeLowCut(double sampleRate, float freq, int numSections)
+    {
+        CutCoefficients cut;
+        cut.numSections = numSections;
+
+        auto order = 2 * numSections;
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            auto q = 1.0 / (2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (2.0 * order)));
+            cut.sections[(size_t) i] = normalise(juce::dsp::IIR::ArrayCoefficients<double>::makeHighPass(sampleRate, freq, q));
+        }
+
+        return cut;
+    }
+
+    //12 dB/oct, and none at all if the profile doesn't have one or it'd be up past nyquist
+    CutCoefficients makeHighCut(double sampleRate, float freq)
+    {
+        CutCoefficients cut;
+
+        if (freq <= 0.0f || freq >= sampleRate * 0.49)
+            return cut;
+
+        auto q = 1.0 / (2.0 * std::cos(juce::MathConstants<double>::pi / 4.0));
+        cut.sections[0] = normalise(juce::dsp::IIR::ArrayCoefficients<double>::makeLowPass(sampleRate, freq, q));
+        cut.numSections = 1;
+
+        return cut;
+    }
+}
+
+//==============================================================================
+int BiquadCoefficients::getDecaySamples(float decayGain) const noexcept
+{
+    //the poles are the roots of z^2 + a1 z + a2
+    auto discriminant = a1 * a1 - 4.0 * a2;
+    auto radius = discriminant < 0.0 ? std::sqrt(a2)
+                                     : (std::abs(a1) + std::sqrt(discriminant)) * 0.5;
+
+    if (radius >= 1.0)
+        return std::numeric_limits<int>::max() / 4;
+
+    if (radius <= 1.0e-9)
+        return 2;
+
+    return (int) std::ceil(std::log((double) decayGain) / std::log(radius)) + 2;
+}
+
+double BiquadCoefficients::getMagnitude(std::complex<double> z) const noexcept
+{
+    auto numerator = b0 + z * (b1 + z * b2);
+    auto denominator = 1.0 + z * (a1 + z * a2);
+    return std::abs(numerator / denominator);
+}
+
+int CutCoefficients::getDecaySamples(float decayGain) const noexcept
+{
+    auto samples = 0;
+
+    for (int i = 0; i < numSections; ++i)
+        samples += sections[(size_t) i].getDecaySamples(decayGain);
+
+    return samples;
+}
+
+double CutCoefficients::getMagnitude(std::complex<double> z) const noexcept
+{
+    auto magnitude = 1.0;
+
+    for (int i = 0; i < numSections; ++i)
+        magnitude *= sections[(size_t) i].getMagnitude(z);
+
+    return magnitude;
+}
+
+int EqCoefficients::getDecaySamples(float decayGain) const noexcept
+{
+    return peakOne.getDecaySamples(decayGain) + peakTwo.getDecaySamples(decayGain)
+         + peakThree.getDecaySamples(decayGain) + lowCut.getDecaySamples(decayGain) + highCut.getDecaySamples(decayGain);
+}
+
+double EqCoefficients::getMagnitude(double frequency, double sampleRate) const noexcept
+{
+    return getMagnitude(std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate));
+}
+
+double EqCoefficients::getMagnitude(std::complex<double> z) const noexcept
+{
+    return peakOne.getMagnitude(z) * peakTwo.getMagnitude(z) * peakThree.getMagnitude(z) * lowCut.getMagnitude(z) * highCut.getMagnitude(z);
+}
+
+//==============================================================================
+std::shared_ptr<const CoefficientBank> CoefficientBank::getShared(double sampleRate, const InstrumentProfiles& profiles)
+{
+    //held weakly so a rate nobody's using any more doesn't keep its bank
+    static juce::CriticalSection lock;
+    static std::map<double, std::weak_ptr<const CoefficientBank>> banks;
+
+    //instances preparing at once for the same rate wait here and then share the first one's bank
+    const juce::ScopedLock sl(lock);
+
+    for (auto it = banks.begin(); it != banks.end();)
+        it = it->second.expired() ? banks.erase(it) : std::next(it);
+
+    auto& slot = banks[sampleRate];
+
+    if (auto existing = slot.lock())
+        if (existing->isBuiltFor(sampleRate, profiles))
+            return existing;
+
+    auto bank = std::make_shared<CoefficientBank>();
+    bank->build(sampleRate, profiles);
+    slot = bank;
+
+    return bank;
+}
+
+void CoefficientBank::build(double sampleRate, const InstrumentProfiles& profiles)
+{
+    if (isBuiltFor(sampleRate, profiles))
+        return;
+
+    numInstruments = profiles.size();
+    entries.resize((size_t) (numInstruments * numSlapSteps));
+    lowCuts.resize((size_t) (numInstruments * numLowCutSlopes));
+    highCuts.resize((size_t) numInstruments);
+
+    for (int instrument = 0; instrument < numInstruments; ++instrument)
+    {
+        auto& eq = profiles.getEq(instrument);
+
+        //the cuts don't care about slap so they only get designed once, at every slope
+        for (int slope = 0; slope < numLowCutSlopes; ++slope)
+            lowCuts[(size_t) (instrument * numLowCutSlopes + slope)] = makeLowCut(sampleRate, eq.cutFreq, slope + 1);
+
+        highCuts[(size_t) instrument] = makeHighCut(sampleRate, eq.highCutFreq);
+
+        for (int step = 0; step < numSlapSteps; ++step)
+        {
+            auto slap = minSlap + (float) step * slapStep;
+            auto& entry = entries[(size_t) (instrument * numSlapSteps + step)];
+
+            entry.peakOne = makePeak(sampleRate, eq.peakOneFreq, eq.peakOneQ, slap * eq.peakOneGain);
+            entry.peakTwo = makePeak(sampleRate, eq.peakTwoFreq, eq.peakTwoQ, slap * eq.peakTwoGain);
+            entry.peakThree = makePeak(sampleRate, eq.peakThreeFreq, eq.peakThreeQ, slap * eq.peakThreeGain);
+        }
+    }
+
+    builtSampleRate = sampleRate;
+}
+
+int CoefficientBank::getSlapIndex(float slapLevel) noexcept
+{
+    return juce::jlimit(0, numSlapSteps - 1, juce::roundToInt((slapLevel - minSlap) / slapStep));
+}
+
+const CoefficientBank::PeakCoefficients& CoefficientBank::getPeaks(int instrumentIndex, int slapIndex) const noexcept
+{
+    jassert(! entries.empty());
+
+    instrumentIndex = juce::jlimit(0, numInstruments - 1, instrumentIndex);
+    slapIndex = juce::jlimit(0, numSlapSteps - 1, slapIndex);
+
+    return entries[(size_t) (instrumentIndex * numSlapSteps + slapIndex)];
+}
+
+EqCoefficients CoefficientBank::get(int instrumentIndex, int slapIndex, int lowCutSlope) const noexcept
+{
+    auto& peaks = getPeaks(instrumentIndex, slapIndex);
+
+    instrumentIndex = juce::jlimit(0, numInstruments - 1, instrumentIndex);
+    lowCutSlope = juce::jlimit(0, numLowCutSlopes - 1, lowCutSlope);
+
+    return { peaks.peakOne, peaks.peakTwo, peaks.peakThree,
+             lowCuts[(size_t) (instrumentIndex * numLowCutSlopes + lowCutSlope)], highCuts[(size_t) instrumentIndex] };
+}
+
+EqCoefficients CoefficientBank::getInterpolated(int instrumentIndex, float slapLevel, int lowCutSlope) const noexcept
+{
+    auto position = juce::jlimit(0.0, (double) (numSlapSteps - 1), ((double) slapLevel - minSlap) / slapStep);
+    auto lowerIndex = juce::jmin((int) position, numSlapSteps - 2);
+    auto amount = position - (double) lowerIndex;
+
+    auto& lower = getPeaks(instrumentIndex, lowerIndex);
+    auto& upper = getPeaks(instrumentIndex, lowerIndex + 1);
+
+    auto blend = [amount] (const BiquadCoefficients& a, const BiquadCoefficients& b)
+    {
+        auto lerp = [amount] (double x, double y) { return x + amount * (y - x); };
+        return BiquadCoefficients{ lerp(a.b0, b.b0), lerp(a.b1, b.b1), lerp(a.b2, b.b2), lerp(a.a1, b.a1), lerp(a.a2, b.a2) };
+    };
+
+    //the cuts are the same at every step, so there's nothing to blend
+    auto eq = get(instrumentIndex, lowerIndex, lowCutSlope);
+    eq.peakOne = blend(lower.peakOne, upper.peakOne);
+    eq.peakTwo = blend(lower.peakTwo, upper.peakTwo);
+    eq.peakThree = blend(lower.peakThree, upper.peakThree);
+
+    return eq;
+}
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    CoefficientBank.h
+
+    Every eq coefficient the plugin can use, for every instrument profile,
+    designed up front in prepareToPlay so the audio thread only ever has to
+    look them up. Banks are shared by every instance in the process running
+    at the same rate, so a big session designs each one once.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "InstrumentProfiles.h"
+
+//one normalised biquad section, in the same order juce keeps them (b0, b1, b2, a1, a2).
+//designed and kept in double so the low cut at high sample rates stays accurate, even if it runs in float
+struct BiquadCoefficients
+{
+    double b0{ 1 }, b1{ 0 }, b2{ 0 }, a1{ 0 }, a2{ 0 };
+
+    //copies the numbers straight into an existing second order coefficients object, no allocating
+    template <typename NumericType>
+    void copyTo(juce::dsp::IIR::Coefficients<NumericType>& dest) const noexcept
+    {
+        jassert(dest.getFilterOrder() == 2);
+
+        auto* raw = dest.getRawCoefficients();
+        raw[0] = (NumericType) b0;
+        raw[1] = (NumericType) b1;
+        raw[2] = (NumericType) b2;
+        raw[3] = (NumericType) a1;
+        raw[4] = (NumericType) a2;
+    }
+
+    //how many samples until the impulse response has died down to decayGain, from the biggest pole
+    int getDecaySamples(float decayGain) const noexcept;
+
+    //|H| at z = e^-jw
+    double getMagnitude(std::complex<double> z) const noexcept;
+};
+
+//a butterworth cut as a cascade of second order sections, only the first numSections of them are used
+struct CutCoefficients
+{
+    //48 dB/oct is four sections
+    static constexpr int maxSections = 4;
+
+    std::array<BiquadCoefficients, maxSections> sections;
+    int numSections = 0;
+
+    int getDecaySamples(float decayGain) const noexcept;
+    double getMagnitude(std::complex<double> z) const noexcept;
+};
+
+//everything the eq needs for one instrument at one slap setting, at one low cut slope
+struct EqCoefficients
+{
+    BiquadCoefficients peakOne, peakTwo, peakThree;
+    CutCoefficients lowCut, highCut;
+
+    //the whole cascade, each stage's tail added up so it errs on the long side
+    int getDecaySamples(float decayGain) const noexcept;
+
+    //the whole cascade's gain at frequency, for drawing it or designing from it
+    double getMagnitude(double frequency, double sampleRate) const noexcept;
+    double getMagnitude(std::complex<double> z) const noexcept;
+};
+
+//==============================================================================
+class CoefficientBank
+{
+public:
+    //the SLAP range gets quantised into steps this size, which is way below what you can hear on the eq
+    static constexpr float minSlap = -6.0f;
+    static constexpr float maxSlap = 36.0f;
+    static constexpr float slapStep = 0.1f;
+    static constexpr int numSlapSteps = (int) ((maxSlap - minSlap) / slapStep + 0.5f) + 1;
+
+    //the LOW_CUT_SLOPE choices, 12 dB/oct (one section) up to 48 dB/oct (four)
+    static constexpr int numLowCutSlopes = CutCoefficients::maxSections;
+
+    //the process wide bank for this rate, designing it if no other instance has. it stays around as long
+    //as anyone's holding it, and nobody changes it once it's built. off the audio thread only
+    static std::shared_ptr<const CoefficientBank> getShared(double sampleRate, const InstrumentProfiles& profiles);
+
+    //designs every instrument at every slap step and every low cut slope, this allocates so only call it off the audio thread
+    void build(double sampleRate, const InstrumentProfiles& profiles);
+
+    bool isBuiltFor(double sampleRate, const InstrumentProfiles& profiles) const noexcept
+    {
+        return builtSampleRate == sampleRate && numInstruments == profiles.size() && ! entries.empty();
+    }
+
+    //same order as the INSTRUMENT parameter
+    int getNumInstruments() const noexcept { return numInstruments; }
+
+    static int getSlapIndex(float slapLevel) noexcept;
+
+    //instrumentIndex is 0 based, same as the parameter, and so is the slope
+    EqCoefficients get(int instrumentIndex, int slapIndex, int lowCutSlope) const noexcept;
+    EqCoefficients get(int instrumentIndex, float slapLevel, int lowCutSlope) const noexcept { return get(instrumentIndex, getSlapIndex(slapLevel), lowCutSlope); }
+
+    //blends the two steps either side of slapLevel, for when it's being ramped. they're only 0.1 dB
+    //apart so the blend is as good as designing it there, and still stable
+    EqCoefficients getInterpolated(int instrumentIndex, float slapLevel, int lowCutSlope) const noexcept;
+
+private:
+    //only the peaks move with slap, so they're kept per slap step and the cuts only per instrument
+    struct PeakCoefficients
+    {
+        BiquadCoefficients peakOne, peakTwo, peakThree;
+    };
+
+    const PeakCoefficients& getPeaks(int instrumentIndex, int slapIndex) const noexcept;
+
+    //[instrument * numSlapSteps + step]
+    std::vector<PeakCoefficients> entries;
+
+    //[instrument * numLowCutSlopes + slope] and [instrument]
+    std::vector<CutCoefficients> lowCuts, highCuts;
+
+    double builtSampleRate = 0;
+    int numInstruments = 0;
+
+    JUCE_LEAK_DETECTOR(CoefficientBank)
+};
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    DryDelay.h
+
+    The untouched input for the MIX knob. Every block gets copied into a
+    ring buffer as it comes in and read back out as many samples late as
+    the wet signal is (oversampling plus the linear phase eq), so the two
+    line up sample for sample and parallel slap doesn't comb filter. The
+    ring is sized in prepare for the longest latency we can have, so
+    switching modes on the audio thread only ever moves the read position.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename SampleType>
+class DryDelay
+{
+public:
+    //message thread, before the audio thread starts
+    void prepare(int numChannels, int maximumBlockSize, int maximumDelaySamples)
+    {
+        maxDelay = juce::jmax(0, maximumDelaySamples);
+        ring.setSize(juce::jmax(1, numChannels), maxDelay + juce::jmax(1, maximumBlockSize));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        ring.clear();
+        writePosition = 0;
+    }
+
+    //audio thread. the host's compensation jumps when the latency does, so the dry just jumps with it
+    void setDelay(int newDelaySamples) noexcept
+    {
+        jassert(newDelaySamples <= maxDelay);
+        delay = juce::jlimit(0, maxDelay, newDelaySamples);
+    }
+
+    int getDelay() const noexcept { return delay; }
+
+    //the block as it came in, before anything's touched it
+    void write(const juce::AudioBuffer<SampleType>& input) noexcept
+    {
+        auto numSamples = input.getNumSamples();
+        auto size = ring.getNumSamples();
+        auto channels = juce::jmin(input.getNumChannels(), ring.getNumChannels());
+
+        jassert(numSamples <= size - maxDelay);
+
+        auto first = juce::jmin(numSamples, size - writePosition);
+
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            ring.copyFrom(channel, writePosition, input, channel, 0, first);
+
+            if (first < numSamples)
+                ring.copyFrom(channel, 0, input, channel, first, numSamples - first);
+        }
+
+        writePosition = (writePosition + numSamples) % size;
+    }
+
+    //crossfades the block that was just written, delayed, into wet. mix goes from startMix to endMix
+    //across the block, 1 being all wet
+    void mixInto(juce::AudioBuffer<SampleType>& wet, float startMix, float endMix) noexcept
+    {
+        auto numSamples = wet.getNumSamples();
+        auto size = ring.getNumSamples();
+        auto channels = juce::jmin(wet.getNumChannels(), ring.getNumChannels());
+
+        //where the block we just wrote starts, then back by the latency
+        auto readPosition = ((writePosition - numSamples - delay) % size + size) % size;
+        auto first = juce::jmin(numSamples, size - readPosition);
+        auto step = numSamples > 0 ? (endMix - startMix) / (float) numSamples : 0.0f;
+
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            auto* out = wet.getWritePointer(channel);
+
+            crossfade(out, ring.getReadPointer(channel, readPosition), first, startMix, step);
+
+            if (first < numSamples)
+                crossfade(out + first, ring.getReadPointer(channel), numSamples - first, startMix + step * (float) first, step);
+        }
+    }
+
+private:
+    //out = dry + (wet - dry) * mix, which is one multiply-add per sample. a still mix goes through the
+    //vector ops, a moving one is a plain loop with no branches that the compiler vectorises on its own
+    static void crossfade(SampleType* out, const SampleType* dry, int numSamples, float startMix, float step) noexcept
+    {
+        if (step == 0.0f)
+        {
+            juce::FloatVectorOperations::multiply(out, (SampleType) startMix, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(out, dry, (SampleType) (1.0f - startMix), numSamples);
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto mix = (SampleType) (startMix + step * (float) i);
+            out[i] = dry[i] + (out[i] - dry[i]) * mix;
+        }
+    }
+
+    juce::AudioBuffer<SampleType> ring;
+    int writePosition = 0, delay = 0, maxDelay = 0;
+
+    JUCE_LEAK_DETECTOR(DryDelay)
+};
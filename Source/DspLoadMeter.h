@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    DspLoadMeter.h
+
+    How long processBlock takes as a percentage of the time the block
+    lasts, which is what actually decides whether the host glitches. The
+    audio thread times every block with the high resolution tick counter
+    and gathers them into a window of about half a second. At the end of
+    each window the min, average, 99th percentile and max get published
+    through atomics, for the editor or the log to pick up whenever they like.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class DspLoadMeter
+{
+public:
+    //all as a percentage of the block's own duration
+    struct Stats
+    {
+        float minPercent = 0, averagePercent = 0, p99Percent = 0, maxPercent = 0;
+        int numBlocks = 0;
+    };
+
+    DspLoadMeter() { histogram.fill(0); }
+
+    //message thread, before the audio thread starts
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        windowSamples = juce::jmax(1, (int) (sampleRate * windowSeconds));
+        startWindow();
+    }
+
+    //audio thread: put one of these at the top of processBlock
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(DspLoadMeter& meterToUse, int numSamplesInBlock) noexcept
+            : meter(meterToUse), numSamples(numSamplesInBlock), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedTimer() { meter.addBlock(juce::Time::getHighResolutionTicks() - startTicks, numSamples); }
+
+    private:
+        DspLoadMeter& meter;
+        int numSamples;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+    void addBlock(juce::int64 ticks, int numSamples) noexcept
+    {
+        if (numSamples <= 0 || sampleRate <= 0)
+            return;
+
+        auto load = (float) (secondsPerTick * (double) ticks * sampleRate / (double) numSamples * 100.0);
+
+        minLoad = juce::jmin(minLoad, load);
+        maxLoad = juce::jmax(maxLoad, load);
+        sumLoad += load;
+        ++histogram[(size_t) juce::jlimit(0, numBins - 1, (int) (load / binWidthPercent))];
+        ++blocksInWindow;
+
+        samplesInWindow += numSamples;
+
+        if (samplesInWindow >= windowSamples)
+            publishWindow();
+    }
+
+    //any thread: the last full window, and how many windows there have been so anyone polling can tell it's new
+    Stats getStats() const noexcept
+    {
+        Stats stats;
+        stats.minPercent = published[0].load(std::memory_order_relaxed);
+        stats.averagePercent = published[1].load(std::memory_order_relaxed);
+        stats.p99Percent = published[2].load(std::memory_order_relaxed);
+        stats.maxPercent = published[3].load(std::memory_order_relaxed);
+        stats.numBlocks = publishedBlocks.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    int getNumWindows() const noexcept { return numWindows.load(std::memory_order_acquire); }
+
+private:
+    static constexpr double windowSeconds = 0.5;
+
+    //half a percent per bin is plenty for a p99, and anything past 200% is a glitch whatever the exact number
+    static constexpr float binWidthPercent = 0.5f;
+    static constexpr int numBins = 400;
+
+    void publishWindow() noexcept
+    {
+        //walk up the histogram until 99% of the blocks are below us
+        auto target = (blocksInWindow * 99 + 99) / 100;
+        auto count = 0, bin = 0;
+
+        for (; bin < numBins - 1; ++bin)
+            if ((count += histogram[(size_t) bin]) >= target)
+                break;
+
+        published[0].store(minLoad, std::memory_order_relaxed);
+        published[1].store((float) (sumLoad / blocksInWindow), std::memory_order_relaxed);
+        published[2].store(juce::jmin(maxLoad, (float) (bin + 1) * binWidthPercent), std::memory_order_relaxed);
+        published[3].store(maxLoad, std::memory_order_relaxed);
+        publishedBlocks.store(blocksInWindow, std::memory_order_relaxed);
+        numWindows.fetch_add(1, std::memory_order_release);
+
+        startWindow();
+    }
+
+    void startWindow() noexcept
+    {
+        histogram.fill(0);
+        minLoad = std::numeric_limits<float>::max();
+        maxLoad = 0;
+        sumLoad = 0;
+        blocksInWindow = 0;
+        samplesInWindow = 0;
+    }
+
+    const double secondsPerTick = 1.0 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    double sampleRate = 0;
+    int windowSamples = 1;
+
+    //audio thread only
+    std::array<int, numBins> histogram;
+    float minLoad = 0, maxLoad = 0;
+    double sumLoad = 0;
+    int blocksInWindow = 0, samplesInWindow = 0;
+
+    std::array<std::atomic<float>, 4> published{};
+    std::atomic<int> publishedBlocks{ 0 }, numWindows{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(DspLoadMeter)
+};
+
+//==============================================================================
+//appends a line to a file every time the meter finishes a window, from the message thread
+class DspLoadLog : private juce::Timer
+{
+public:
+    DspLoadLog(const DspLoadMeter& meterToWatch, const juce::File& file)
+        : meter(meterToWatch), stream(file)
+    {
+        if (stream.openedOk())
+            startTimer(250);
+    }
+
+    ~DspLoadLog() override { stopTimer(); }
+
+    //where to log to, from the SLAPS_DSP_LOAD_LOG environment variable. empty means don't
+    static juce::File getFileFromEnvironment()
+    {
+        auto path = juce::SystemStats::getEnvironmentVariable("SLAPS_DSP_LOAD_LOG", {});
+        return path.isNotEmpty() ? juce::File::getCurrentWorkingDirectory().getChildFile(path) : juce::File();
+    }
+
+private:
+    void timerCallback() override
+    {
+        auto windows = meter.getNumWindows();
+
+        if (windows == lastWindow)
+            return;
+
+        lastWindow = windows;
+        auto stats = meter.getStats();
+
+        stream << juce::Time::getCurrentTime().toISO8601(true) << " blocks " << stats.numBlocks
+               << " min " << juce::String(stats.minPercent, 2) << "% avg " << juce::String(stats.averagePercent, 2)
+               << "% p99 " << juce::String(stats.p99Percent, 2) << "% max " << juce::String(stats.maxPercent, 2) << "%\n";
+        stream.flush();
+    }
+
+    const DspLoadMeter& meter;
+    juce::FileOutputStream stream;
+    int lastWindow = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(DspLoadLog)
+};
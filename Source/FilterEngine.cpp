@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    FilterEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterEngine.h"
+
+template <typename SampleType>
+void FilterEngine<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxNumChannels);
+
+    numGroups = juce::jlimit((size_t) 1, maxNumGroups, (spec.numChannels + numLanes - 1) / numLanes);
+
+    interleaved = juce::dsp::AudioBlock<SIMDFloat>(interleavedData, numGroups, spec.maximumBlockSize);
+
+    //lanes with no channel in them never get written, so they stay silent from here on
+    interleaved.clear();
+
+    //every stage starts out second order and passing through, until setCoefficients says otherwise
+    for (auto& stageCoefficients : coefficients)
+        stageCoefficients = new juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+
+    for (auto& groupStages : stages)
+    {
+        for (size_t stage = 0; stage < numStages; ++stage)
+        {
+            //each group's cascade only ever sees one (wide) channel. preparing resets the state to match the order,
+            //so process never has to reallocate it
+            groupStages[stage].coefficients = coefficients[stage];
+            groupStages[stage].prepare({ spec.sampleRate, spec.maximumBlockSize, 1 });
+        }
+    }
+
+    stageActive.fill(false);
+    setActiveStages(1, false);
+}
+
+template <typename SampleType>
+void FilterEngine<SampleType>::reset()
+{
+    for (auto& groupStages : stages)
+        for (auto& filter : groupStages)
+            filter.reset();
+}
+
+template <typename SampleType>
+void FilterEngine<SampleType>::setCoefficients(const EqCoefficients& eq) noexcept
+{
+    jassert(eq.lowCut.numSections > 0 && eq.highCut.numSections <= 1);
+
+    //the groups all share these, so there's only one set to fill in
+    for (int section = 0; section < eq.lowCut.numSections; ++section)
+        eq.lowCut.sections[(size_t) section].copyTo(*coefficients[(size_t) (LowCut + section)]);
+
+    eq.peakOne.copyTo(*coefficients[PeakOne]);
+    eq.peakTwo.copyTo(*coefficients[PeakTwo]);
+    eq.peakThree.copyTo(*coefficients[PeakThree]);
+
+    if (eq.highCut.numSections > 0)
+        eq.highCut.sections[0].copyTo(*coefficients[HighCut]);
+
+    setActiveStages(eq.lowCut.numSections, eq.highCut.numSections > 0);
+}
+
+template <typename SampleType>
+void FilterEngine<SampleType>::setActiveStages(int numLowCutSections, bool hasHighCut) noexcept
+{
+    std::array<bool, numStages> shouldBeActive{};
+
+    for (int section = 0; section < juce::jlimit(1, CutCoefficients::maxSections, numLowCutSections); ++section)
+        shouldBeActive[(size_t) (LowCut + section)] = true;
+
+    shouldBeActive[PeakOne] = shouldBeActive[PeakTwo] = shouldBeActive[PeakThree] = true;
+    shouldBeActive[HighCut] = hasHighCut;
+
+    numActiveStages = 0;
+
+    for (size_t stage = 0; stage < numStages; ++stage)
+    {
+        if (! shouldBeActive[stage])
+            continue;
+
+        //whatever it had in it from the last time it was running doesn't belong to this signal
+        if (! stageActive[stage])
+            for (size_t group = 0; group < numGroups; ++group)
+                stages[group][stage].reset();
+
+        activeStages[(size_t) numActiveStages++] = (int) stage;
+    }
+
+    stageActive = shouldBeActive;
+}
+
+template <typename SampleType>
+void FilterEngine<SampleType>::setBypassed(bool shouldBeBypassed) noexcept
+{
+    bypassed = shouldBeBypassed;
+}
+
+template <typename SampleType>
+void FilterEngine<SampleType>::process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    auto numChannels = block.getNumChannels();
+    auto numSamples = block.getNumSamples();
+
+    jassert(numChannels <= numGroups * numLanes);
+    jassert(numSamples <= interleaved.getNumSamples());
+
+    //squish the channels together so sample i of channel ch sits in its lane of register i
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* channelData = block.getChannelPointer(ch);
+        auto* wide = getChannelData(ch);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            wide[i * numLanes] = channelData[i];
+    }
+
+    processInterleaved(numSamples);
+
+    //and pull them back apart
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* channelData = block.getChannelPointer(ch);
+        auto* wide = getChannelData(ch);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            channelData[i] = wide[i * numLanes];
+    }
+}
+
+template <typename SampleType>
+void FilterEngine<SampleType>::processInterleaved(size_t numSamples) noexcept
+{
+    jassert(numSamples <= interleaved.getNumSamples());
+
+    if (bypassed)
+        return;
+
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+        auto groupBlock = interleaved.getSingleChannelBlock(group).getSubBlock(0, numSamples);
+        auto context = juce::dsp::ProcessContextReplacing<SIMDFloat>(groupBlock);
+
+        for (int i = 0; i < numActiveStages; ++i)
+            stages[group][(size_t) activeStages[(size_t) i]].process(context);
+    }
+}
+
+template class FilterEngine<float>;
+template class FilterEngine<double>;
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    FilterEngine.h
+
+    The eq cascade (the low cut, PeakOne/Two/Three and the high cut) for
+    every channel at once. The channels get interleaved into SIMDRegister
+    lanes so a single cascade of juce IIR filters works on a whole group of
+    channels with each instruction, instead of running one chain per
+    channel. Layouts wider than one register get split into groups, each
+    with its own cascade, all of them sharing the same coefficients. The
+    low cut is one to four butterworth sections depending on its slope and
+    not every instrument has a high cut, so only the stages the current
+    coefficients use get run, the rest are skipped rather than passing
+    samples through. It comes in float and double, for hosts that process
+    in double precision.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientBank.h"
+
+template <typename SampleType>
+class FilterEngine
+{
+public:
+    using SIMDFloat = juce::dsp::SIMDRegister<SampleType>;
+
+    //the biggest layout we take, 7.1.4 plus a few spare
+    static constexpr size_t maxNumChannels = 16;
+
+    //one lane per channel, so this is how many channels fit in a group
+    static constexpr size_t numLanes = SIMDFloat::size();
+    static constexpr size_t maxNumGroups = (maxNumChannels + numLanes - 1) / numLanes;
+
+    //allocates the interleaving buffer and gives every stage its coefficients, so call it off the audio thread
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    //these just copy floats into the existing filters (and reset any stage that's just been switched on),
+    //safe on the audio thread
+    void setCoefficients(const EqCoefficients& eq) noexcept;
+    void setBypassed(bool shouldBeBypassed) noexcept;
+
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    //for callers that do their own interleaving, like the fused kernel in the processor.
+    //sample i of channel ch lives at getChannelData(ch)[i * numLanes]
+    SampleType* getChannelData(size_t channel) noexcept
+    {
+        jassert(channel < numGroups * numLanes);
+        return toBasePointer(interleaved.getChannelPointer(channel / numLanes)) + channel % numLanes;
+    }
+
+    size_t getMaxInterleavedSamples() const noexcept { return interleaved.getNumSamples(); }
+    void processInterleaved(size_t numSamples) noexcept;
+
+private:
+    using Filter = juce::dsp::IIR::Filter<SIMDFloat>;
+    using CoefficientsPtr = typename juce::dsp::IIR::Coefficients<SampleType>::Ptr;
+
+    enum Stage
+    {
+        LowCut,
+        PeakOne = LowCut + CutCoefficients::maxSections,
+        PeakTwo,
+        PeakThree,
+        HighCut,
+        numStages
+    };
+
+    //makes the list of stages to run, resetting any that weren't in it last time so they don't start from old state
+    void setActiveStages(int numLowCutSections, bool hasHighCut) noexcept;
+
+    //all the groups sit next to each other, and only the first numGroups get used
+    std::array<std::array<Filter, numStages>, maxNumGroups> stages;
+    size_t numGroups = 1;
+
+    //every group reads the same coefficient objects, so updating them once updates everything
+    std::array<CoefficientsPtr, numStages> coefficients;
+
+    //the stages that get run, in order
+    std::array<int, numStages> activeStages{};
+    std::array<bool, numStages> stageActive{};
+    int numActiveStages = 0;
+
+    bool bypassed = false;
+
+    //one (wide) channel per group, laid out sample by sample with the group's channels side by side
+    juce::HeapBlock<char> interleavedData;
+    juce::dsp::AudioBlock<SIMDFloat> interleaved;
+
+    static SampleType* toBasePointer(SIMDFloat* r) noexcept { return reinterpret_cast<SampleType*>(r); }
+
+    JUCE_LEAK_DETECTOR(FilterEngine)
+};
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    InstrumentProfiles.cpp
+
+  ==============================================================================
+*/
+
+#include "InstrumentProfiles.h"
+
+InstrumentProfiles::InstrumentProfiles()
+{
+    for (auto& instrument : builtIn)
+    {
+        names.add(instrument.name);
+        eqs.push_back(instrument.eq);
+    }
+
+    loadUserProfiles(getUserFile());
+}
+
+const InstrumentEq& InstrumentProfiles::getEq(int index) const noexcept
+{
+    return eqs[(size_t) juce::jlimit(0, size() - 1, index)];
+}
+
+juce::StringArray InstrumentProfiles::getParameterChoices() const
+{
+    auto choices = names;
+
+    for (int slot = size(); slot < maxNumInstruments; ++slot)
+        choices.add("Empty Slot " + juce::String(slot - numBuiltIn + 1));
+
+    return choices;
+}
+
+juce::File InstrumentProfiles::getUserFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("Slaps").getChildFile("Instruments.xml");
+}
+
+void InstrumentProfiles::loadUserProfiles(const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return;
+
+    auto xml = juce::XmlDocument::parse(file);
+
+    if (xml == nullptr || ! xml->hasTagName("INSTRUMENTS"))
+    {
+        DBG("couldn't read any instruments from " + file.getFullPathName());
+        return;
+    }
+
+    for (auto* element : xml->getChildWithTagNameIterator("INSTRUMENT"))
+    {
+        auto name = element->getStringAttribute("name").trim();
+
+        //a name that's already taken would be two choices nobody can tell apart
+        if (name.isEmpty() || names.contains(name, true) || size() >= maxNumInstruments)
+            continue;
+
+        //starts out flat, then takes whatever the file sets, kept to something the filters can actually do
+        auto eq = builtIn[0].eq;
+
+        auto read = [element] (const char* attribute, float& value, float minValue, float maxValue)
+        {
+            value = juce::jlimit(minValue, maxValue, (float) element->getDoubleAttribute(attribute, value));
+        };
+
+        read("peakOneFreq", eq.peakOneFreq, 20.0f, 20000.0f);
+        read("peakOneQ", eq.peakOneQ, 0.1f, 20.0f);
+        read("peakOneGain", eq.peakOneGain, -1.0f, 1.0f);
+        read("peakTwoFreq", eq.peakTwoFreq, 20.0f, 20000.0f);
+        read("peakTwoQ", eq.peakTwoQ, 0.1f, 20.0f);
+        read("peakTwoGain", eq.peakTwoGain, -1.0f, 1.0f);
+        read("peakThreeFreq", eq.peakThreeFreq, 20.0f, 20000.0f);
+        read("peakThreeQ", eq.peakThreeQ, 0.1f, 20.0f);
+        read("peakThreeGain", eq.peakThreeGain, -1.0f, 1.0f);
+        read("cutFreq", eq.cutFreq, 10.0f, 2000.0f);
+        read("lowCrossover", eq.lowCrossover, 20.0f, 20000.0f);
+        read("highCrossover", eq.highCrossover, eq.lowCrossover, 20000.0f);
+
+        //0 (or leaving it out) is no high cut
+        read("highCutFreq", eq.highCutFreq, 0.0f, 20000.0f);
+
+        names.add(name);
+        eqs.push_back(eq);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    InstrumentProfiles.h
+
+    What the eq does for each choice of the INSTRUMENT parameter. The built
+    in ones are a constexpr table, and anything in the user's
+    Instruments.xml gets added after them when the first instance starts,
+    so toms, claps and so on can be added without a rebuild. Every instance
+    in the process shares the one list.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//the eq settings for one instrument, gains are how many dB each peak moves per dB of slap.
+//the crossovers are where multiband mode splits it into low, mid and high, and a high cut of 0 means there isn't one
+struct InstrumentEq
+{
+    float peakOneFreq, peakOneQ, peakOneGain;
+    float peakTwoFreq, peakTwoQ, peakTwoGain;
+    float peakThreeFreq, peakThreeQ, peakThreeGain;
+    float cutFreq;
+    float lowCrossover, highCrossover;
+    float highCutFreq;
+};
+
+struct BuiltInInstrument
+{
+    const char* name;
+    InstrumentEq eq;
+};
+
+class InstrumentProfiles
+{
+public:
+    //always first and in this order, so saved sessions and automation keep pointing at the same ones
+    static constexpr std::array<BuiltInInstrument, 4> builtIn
+    {{
+        //none, the peaks stay flat
+        { "None",   { 387.f, 1.9365f, 0.f,    200.f, 0.866f, 0.f,     10000.f, 0.6666667f, 0.f,     20.f,   200.f,  2500.f, 0.f } },
+        { "Kick",   { 63.f,  1.0541f, 0.3f,   433.f, 0.866f, -0.2f,   5477.f,  0.782464f,  0.25f,   20.f,   120.f,  2500.f, 0.f } },
+        { "Snare",  { 137.f, 0.979796f, 0.3f, 600.f, 1.2f,   -0.2f,   7746.f,  0.704179f,  0.25f,   75.f,   250.f,  4000.f, 14000.f } },
+        { "Hi Hat", { 387.f, 1.9365f, 0.3f,   200.f, 0.866f, -0.2f,   10000.f, 0.6666667f, 0.25f,   275.f,  1000.f, 7000.f, 17000.f } }
+    }};
+
+    static constexpr int numBuiltIn = (int) builtIn.size();
+
+    //every one gets a coefficient bank per oversampling factor, so keep the user file from getting silly
+    static constexpr int maxNumInstruments = 32;
+
+    //reads the user file, so this happens once when the first instance gets made
+    InstrumentProfiles();
+
+    int size() const noexcept { return (int) eqs.size(); }
+    const InstrumentEq& getEq(int index) const noexcept;
+    const juce::StringArray& getNames() const noexcept { return names; }
+
+    //what INSTRUMENT offers, always maxNumInstruments of them with the slots the user file doesn't fill
+    //named as empty. hosts keep choices normalised, so the count can't change with what's in the file
+    juce::StringArray getParameterChoices() const;
+
+    //an INSTRUMENT value as an index into this list, empty slots are flat the same as None
+    int resolve(int parameterIndex) const noexcept { return juce::isPositiveAndBelow(parameterIndex, size()) ? parameterIndex : 0; }
+
+    //<INSTRUMENTS><INSTRUMENT name="Tom" peakOneFreq="90" ... /></INSTRUMENTS>, anything left out is flat
+    static juce::File getUserFile();
+
+private:
+    void loadUserProfiles(const juce::File& file);
+
+    juce::StringArray names;
+    std::vector<InstrumentEq> eqs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InstrumentProfiles)
+};
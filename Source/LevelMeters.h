@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    LevelMeters.h
+
+    Peak and RMS for every channel at the input (after the gain), after the
+    compressor and at the output, plus the compressor's gain reduction.
+    The audio thread measures them while it processes and pushes them once
+    per block through atomics, the editor picks them up whenever it likes.
+    Peaks are "biggest since the last look" so the editor never misses one
+    between timer ticks, and any holding or falling off happens GUI side.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class LevelMeters
+{
+public:
+    enum Point
+    {
+        input,
+        postCompressor,
+        output,
+        numPoints
+    };
+
+    static constexpr int maxNumChannels = 16;
+
+    //what one block measured, filled in on the audio thread and then pushed in one go
+    struct BlockLevels
+    {
+        std::array<std::array<float, maxNumChannels>, numPoints> peak{}, sumOfSquares{};
+
+        void clear() noexcept { *this = {}; }
+
+        //this is the loop the staged path uses, the fused kernel does the same thing inline.
+        //sumScale is for measuring oversampled audio, so the RMS still comes out per original sample
+        template <typename SampleType>
+        void measure(Point point, int channel, const SampleType* data, int numSamples, float sumScale = 1.0f) noexcept
+        {
+            if (numSamples <= 0)
+                return;
+
+            auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+            auto blockPeak = (float) juce::jmax(-range.getStart(), range.getEnd());
+
+            add(point, channel, blockPeak, (float) getSumOfSquares(data, numSamples) * sumScale);
+        }
+
+        //a whole register of squares at a time, the compiler won't reorder a plain float sum into this by itself
+        template <typename SampleType>
+        static SampleType getSumOfSquares(const SampleType* data, int numSamples) noexcept
+        {
+            using Register = juce::dsp::SIMDRegister<SampleType>;
+
+            auto* aligned = Register::getNextSIMDAlignedPtr(const_cast<SampleType*>(data));
+            auto numBefore = juce::jmin(numSamples, (int) (aligned - data));
+            auto numRegisters = (numSamples - numBefore) / (int) Register::size();
+
+            SampleType sum = 0;
+
+            for (int i = 0; i < numBefore; ++i)
+                sum += data[i] * data[i];
+
+            auto sums = Register::expand((SampleType) 0);
+
+            for (int i = 0; i < numRegisters; ++i)
+            {
+                auto samples = Register::fromRawArray(aligned + i * (int) Register::size());
+                sums += samples * samples;
+            }
+
+            sum += sums.sum();
+
+            for (int i = numBefore + numRegisters * (int) Register::size(); i < numSamples; ++i)
+                sum += data[i] * data[i];
+
+            return sum;
+        }
+
+        void add(Point point, int channel, float peakValue, float sum) noexcept
+        {
+            peak[(size_t) point][(size_t) channel] = juce::jmax(peak[(size_t) point][(size_t) channel], peakValue);
+            sumOfSquares[(size_t) point][(size_t) channel] += sum;
+        }
+    };
+
+    //audio thread, once per block
+    void push(const BlockLevels& levels, int numChannelsMeasured, int numSamples) noexcept
+    {
+        numChannels.store(numChannelsMeasured, std::memory_order_relaxed);
+
+        if (numSamples <= 0)
+            return;
+
+        auto inputSum = 0.0f, compressedSum = 0.0f;
+
+        for (size_t point = 0; point < numPoints; ++point)
+        {
+            for (size_t ch = 0; ch < (size_t) numChannelsMeasured; ++ch)
+            {
+                raiseTo(peaks[point][ch], levels.peak[point][ch]);
+
+                rmsLevels[point][ch].store(std::sqrt(levels.sumOfSquares[point][ch] / (float) numSamples), std::memory_order_relaxed);
+            }
+        }
+
+        for (size_t ch = 0; ch < (size_t) numChannelsMeasured; ++ch)
+        {
+            inputSum += levels.sumOfSquares[input][ch];
+            compressedSum += levels.sumOfSquares[postCompressor][ch];
+        }
+
+        //how much quieter the compressor made the block, across every channel
+        auto reduction = inputSum > 1.0e-12f ? juce::jmin(0.0f, 10.0f * std::log10(compressedSum / inputSum + 1.0e-12f)) : 0.0f;
+        pushGainReduction(reduction);
+    }
+
+    //audio thread, for compressors that know their own gain reduction in dB (negative means reducing)
+    void pushGainReduction(float decibels) noexcept
+    {
+        //the same as a peak, just the other way up
+        lowerTo(gainReduction, decibels);
+    }
+
+    //==============================================================================
+    //gui thread: the biggest peak (as a gain) since the last time anyone asked
+    float takePeak(Point point, int channel) noexcept
+    {
+        return peaks[(size_t) point][(size_t) channel].exchange(0.0f, std::memory_order_relaxed);
+    }
+
+    //gui thread: the RMS (as a gain) of the last block
+    float getRms(Point point, int channel) const noexcept
+    {
+        return rmsLevels[(size_t) point][(size_t) channel].load(std::memory_order_relaxed);
+    }
+
+    //gui thread: the most gain reduction in dB since the last time anyone asked
+    float takeGainReduction() noexcept
+    {
+        return gainReduction.exchange(0.0f, std::memory_order_relaxed);
+    }
+
+    int getNumChannels() const noexcept { return numChannels.load(std::memory_order_relaxed); }
+
+private:
+    //the editor takes these with exchange, so a plain load then store could put back a value from before it
+    //looked and lose whatever arrived in between. compare_exchange only ever moves it the right way
+    static void raiseTo(std::atomic<float>& held, float value) noexcept
+    {
+        auto current = held.load(std::memory_order_relaxed);
+
+        while (value > current && ! held.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    static void lowerTo(std::atomic<float>& held, float value) noexcept
+    {
+        auto current = held.load(std::memory_order_relaxed);
+
+        while (value < current && ! held.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    using AtomicLevels = std::array<std::array<std::atomic<float>, maxNumChannels>, numPoints>;
+
+    AtomicLevels peaks{}, rmsLevels{};
+    std::atomic<float> gainReduction{ 0.0f };
+    std::atomic<int> numChannels{ 0 };
+};
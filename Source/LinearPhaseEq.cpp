@@ -0,0 +1,298 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEq.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEq.h"
+
+namespace
+{
+    int getOrder(int size)
+    {
+        jassert(juce::isPowerOfTwo(size));
+        return juce::findHighestSetBit((juce::uint32) size);
+    }
+}
+
+//==============================================================================
+LinearPhaseEq::~LinearPhaseEq()
+{
+    if (registered)
+        designThread->removeTimeSliceClient(this);
+}
+
+int LinearPhaseEq::getKernelSize(double sampleRate) noexcept
+{
+    return juce::jlimit(2 * partitionSize, 1 << 15, juce::nextPowerOfTwo(juce::roundToInt(sampleRate * 0.085)));
+}
+
+void LinearPhaseEq::prepare(const juce::dsp::ProcessSpec& spec, const EqCoefficients& eq)
+{
+    //the design thread mustn't be halfway through a kernel while everything gets resized
+    if (registered)
+    {
+        designThread->removeTimeSliceClient(this);
+        registered = false;
+    }
+
+    numChannels = juce::jlimit((size_t) 1, maxNumChannels, (size_t) spec.numChannels);
+    kernelSize = getKernelSize(spec.sampleRate);
+    numPartitions = (size_t) (kernelSize / partitionSize);
+
+    //bins 0 to partitionSize of a 2 * partitionSize FFT, rounded up to whole registers
+    numVectors = ((size_t) partitionSize + 1 + SIMDFloat::size() - 1) / SIMDFloat::size();
+
+    auto zero = SIMDFloat::expand(0.0f);
+    auto partitionBufferSize = (size_t) (4 * partitionSize);
+
+    fft = std::make_unique<juce::dsp::FFT>(getOrder(2 * partitionSize));
+    inputWindows.assign(numChannels * 2 * partitionSize, 0.0f);
+    outputs.assign(numChannels * partitionSize, 0.0f);
+    fftBuffer.assign(partitionBufferSize, 0.0f);
+    crossfadeBuffer.assign(partitionSize, 0.0f);
+    delayLine.assign(numChannels * numPartitions * getSpectrumSize(), zero);
+    accumulator.assign(getSpectrumSize(), zero);
+
+    for (auto& kernel : kernels)
+        kernel.assign(numPartitions * getSpectrumSize(), zero);
+
+    kernelFft = std::make_unique<juce::dsp::FFT>(getOrder(kernelSize));
+    partitionFft = std::make_unique<juce::dsp::FFT>(getOrder(2 * partitionSize));
+    kernelBuffer.assign(2 * (size_t) kernelSize, 0.0f);
+    partitionBuffer.assign(partitionBufferSize, 0.0f);
+
+    //one longer than the kernel so it's symmetric about the centre sample and 0 at the very start
+    window.resize((size_t) kernelSize + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                             juce::dsp::WindowingFunction<float>::blackman, false);
+
+    //anything still waiting was for the old sample rate
+    EqCoefficients stale;
+    requests.pull(stale);
+
+    designSlot = 0;
+    playSlot = 1;
+    spareSlot.store(2);
+
+    design(eq, kernels[(size_t) playSlot]);
+    reset();
+
+    designThread->addTimeSliceClient(this);
+    registered = true;
+}
+
+void LinearPhaseEq::reset() noexcept
+{
+    std::fill(inputWindows.begin(), inputWindows.end(), 0.0f);
+    std::fill(outputs.begin(), outputs.end(), 0.0f);
+    std::fill(delayLine.begin(), delayLine.end(), SIMDFloat::expand(0.0f));
+
+    position = 0;
+    delayLinePosition = 0;
+}
+
+void LinearPhaseEq::requestKernel(const EqCoefficients& eq) noexcept
+{
+    requests.publish(eq);
+}
+
+//==============================================================================
+template <typename SampleType>
+void LinearPhaseEq::process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    auto numSamples = block.getNumSamples();
+    auto numBlockChannels = juce::jmin(block.getNumChannels(), numChannels);
+
+    jassert(block.getNumChannels() <= numChannels);
+
+    size_t done = 0;
+
+    while (done < numSamples)
+    {
+        auto numToDo = juce::jmin(numSamples - done, (size_t) (partitionSize - position));
+
+        //in goes the new input, out comes what the last partition worked out for these samples
+        for (size_t ch = 0; ch < numBlockChannels; ++ch)
+        {
+            auto* data = block.getChannelPointer(ch) + done;
+            auto* input = inputWindows.data() + ch * 2 * partitionSize + partitionSize + (size_t) position;
+            auto* output = outputs.data() + ch * partitionSize + (size_t) position;
+
+            for (size_t i = 0; i < numToDo; ++i)
+            {
+                input[i] = (float) data[i];
+                data[i] = (SampleType) output[i];
+            }
+        }
+
+        position += (int) numToDo;
+        done += numToDo;
+
+        if (position == partitionSize)
+        {
+            processPartition();
+            position = 0;
+        }
+    }
+}
+
+template void LinearPhaseEq::process<float>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void LinearPhaseEq::process<double>(const juce::dsp::ProcessContextReplacing<double>&) noexcept;
+
+void LinearPhaseEq::processPartition() noexcept
+{
+    auto lanes = SIMDFloat::size();
+
+    //the newest spectrum goes in front of the older ones, which are numPartitions slots round the ring
+    delayLinePosition = (delayLinePosition + numPartitions - 1) % numPartitions;
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* inputWindow = inputWindows.data() + ch * 2 * partitionSize;
+
+        std::copy(inputWindow, inputWindow + 2 * partitionSize, fftBuffer.begin());
+        fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+        auto* real = reinterpret_cast<float*>(delayLine.data() + (ch * numPartitions + delayLinePosition) * getSpectrumSize());
+        auto* imag = real + numVectors * lanes;
+
+        for (size_t bin = 0; bin <= (size_t) partitionSize; ++bin)
+        {
+            real[bin] = fftBuffer[bin * 2];
+            imag[bin] = fftBuffer[bin * 2 + 1];
+        }
+
+        //slide along so this partition is the first half of the next one
+        std::copy(inputWindow + partitionSize, inputWindow + 2 * partitionSize, inputWindow);
+    }
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        convolve(kernels[(size_t) playSlot].data(), ch, outputs.data() + ch * partitionSize);
+
+    //only look for a new kernel once the old one's finished with, handing playSlot back lets the designer reuse it
+    if ((spareSlot.load(std::memory_order_acquire) & freshFlag) == 0)
+        return;
+
+    playSlot = spareSlot.exchange(playSlot, std::memory_order_acq_rel) & slotMask;
+
+    //the same input through the new kernel, faded in across the partition so there's no step
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        convolve(kernels[(size_t) playSlot].data(), ch, crossfadeBuffer.data());
+
+        auto* output = outputs.data() + ch * partitionSize;
+
+        for (int i = 0; i < partitionSize; ++i)
+        {
+            auto amount = (float) (i + 1) / (float) partitionSize;
+            output[i] += amount * (crossfadeBuffer[(size_t) i] - output[i]);
+        }
+    }
+}
+
+void LinearPhaseEq::convolve(const SIMDFloat* kernel, size_t channel, float* output) noexcept
+{
+    auto lanes = SIMDFloat::size();
+    auto spectrumSize = getSpectrumSize();
+
+    std::fill(accumulator.begin(), accumulator.end(), SIMDFloat::expand(0.0f));
+
+    auto* accumulatedReal = accumulator.data();
+    auto* accumulatedImag = accumulatedReal + numVectors;
+
+    //every input spectrum times the kernel partition that lines up with it, numVectors bins at a time
+    for (size_t partition = 0; partition < numPartitions; ++partition)
+    {
+        auto slot = (delayLinePosition + partition) % numPartitions;
+
+        auto* inputReal = delayLine.data() + (channel * numPartitions + slot) * spectrumSize;
+        auto* inputImag = inputReal + numVectors;
+        auto* kernelReal = kernel + partition * spectrumSize;
+        auto* kernelImag = kernelReal + numVectors;
+
+        for (size_t v = 0; v < numVectors; ++v)
+        {
+            accumulatedReal[v] += inputReal[v] * kernelReal[v] - inputImag[v] * kernelImag[v];
+            accumulatedImag[v] += inputReal[v] * kernelImag[v] + inputImag[v] * kernelReal[v];
+        }
+    }
+
+    auto* real = reinterpret_cast<const float*>(accumulatedReal);
+    auto* imag = real + numVectors * lanes;
+
+    for (size_t bin = 0; bin <= (size_t) partitionSize; ++bin)
+    {
+        fftBuffer[bin * 2] = real[bin];
+        fftBuffer[bin * 2 + 1] = imag[bin];
+    }
+
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    //overlap-save: the first half has wrapped round, the second half is this partition's output
+    std::copy(fftBuffer.begin() + partitionSize, fftBuffer.begin() + 2 * partitionSize, output);
+}
+
+//==============================================================================
+int LinearPhaseEq::useTimeSlice()
+{
+    EqCoefficients eq;
+
+    if (requests.pull(eq))
+    {
+        design(eq, kernels[(size_t) designSlot]);
+        designSlot = spareSlot.exchange(designSlot | freshFlag, std::memory_order_acq_rel) & slotMask;
+    }
+
+    //requests only come in when slap or the instrument move, so a look every 10 ms is plenty
+    return 10;
+}
+
+void LinearPhaseEq::design(const EqCoefficients& eq, std::vector<SIMDFloat>& kernel)
+{
+    auto size = (size_t) kernelSize;
+    auto lanes = SIMDFloat::size();
+
+    std::fill(kernelBuffer.begin(), kernelBuffer.end(), 0.0f);
+
+    //the cascade's magnitude at every bin with no phase at all, and every other bin flipped
+    //so the impulse comes out centred on the middle sample instead of wrapped round sample 0
+    for (size_t bin = 0; bin <= size / 2; ++bin)
+    {
+        auto z = std::polar(1.0, -juce::MathConstants<double>::twoPi * (double) bin / (double) size);
+
+        auto magnitude = eq.getMagnitude(z);
+
+        kernelBuffer[bin * 2] = (float) (bin % 2 == 0 ? magnitude : -magnitude);
+    }
+
+    kernelFft->performRealOnlyInverseTransform(kernelBuffer.data());
+
+    for (size_t i = 0; i < size; ++i)
+        kernelBuffer[i] *= window[i];
+
+    //then cut into partitions, each zero padded to the FFT size and stored the way convolve wants it
+    for (size_t partition = 0; partition < numPartitions; ++partition)
+    {
+        auto* source = kernelBuffer.data() + partition * partitionSize;
+
+        std::fill(partitionBuffer.begin(), partitionBuffer.end(), 0.0f);
+        std::copy(source, source + partitionSize, partitionBuffer.begin());
+        partitionFft->performRealOnlyForwardTransform(partitionBuffer.data(), true);
+
+        auto* spectrum = kernel.data() + partition * getSpectrumSize();
+        std::fill(spectrum, spectrum + getSpectrumSize(), SIMDFloat::expand(0.0f));
+
+        auto* real = reinterpret_cast<float*>(spectrum);
+        auto* imag = real + numVectors * lanes;
+
+        for (size_t bin = 0; bin <= (size_t) partitionSize; ++bin)
+        {
+            real[bin] = partitionBuffer[bin * 2];
+            imag[bin] = partitionBuffer[bin * 2 + 1];
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEq.h
+
+    The same eq curve as FilterEngine, but as a linear phase FIR so it
+    doesn't smear the phase against the dry mics on a parallel bus. The
+    magnitude of the whole IIR cascade gets sampled, turned into a windowed
+    symmetric kernel and split into equal partitions, then run as a
+    uniformly partitioned FFT convolution (overlap-save) so a long kernel
+    costs one small FFT each way per partition plus a multiply-add per bin.
+    Kernels are designed on a background thread shared by every instance
+    and crossfaded in over one partition when they arrive.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientBank.h"
+#include "SnapshotSlot.h"
+
+class LinearPhaseEq : private juce::TimeSliceClient
+{
+public:
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t maxNumChannels = 16;
+
+    //how much gets buffered before each convolution, which is also most of the latency on top of the kernel's centre
+    static constexpr int partitionSize = 256;
+
+    LinearPhaseEq() = default;
+    ~LinearPhaseEq() override;
+
+    //allocates everything and designs the first kernel straight away, so only call it off the audio thread
+    void prepare(const juce::dsp::ProcessSpec& spec, const EqCoefficients& eq);
+    void reset() noexcept;
+
+    //audio thread: hands eq to the design thread, process crossfades to the new kernel once it's built
+    void requestKernel(const EqCoefficients& eq) noexcept;
+
+    //runs in float either way, which is far below anything the windowing does to the curve
+    template <typename SampleType>
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    //the kernel's centre plus one partition of buffering
+    int getLatencySamples() const noexcept { return partitionSize + kernelSize / 2; }
+
+    //how long the output keeps going once the input stops, not counting the latency
+    int getTailSamples() const noexcept { return kernelSize / 2; }
+
+    //long enough that the low cut and the kick's low peak keep their shape, about 85 ms
+    static int getKernelSize(double sampleRate) noexcept;
+
+private:
+    //one thread for every instance in the process, designing only takes a millisecond or so
+    struct DesignThread : public juce::TimeSliceThread
+    {
+        DesignThread() : juce::TimeSliceThread("Slaps linear phase eq") { startThread(); }
+        ~DesignThread() override { stopThread(2000); }
+    };
+
+    int useTimeSlice() override;
+
+    //fills kernel with the partition spectra of eq's magnitude response
+    void design(const EqCoefficients& eq, std::vector<SIMDFloat>& kernel);
+
+    //one partition through every channel, crossfading if a new kernel has turned up
+    void processPartition() noexcept;
+    void convolve(const SIMDFloat* kernel, size_t channel, float* output) noexcept;
+
+    //a partition's spectrum is its real parts then its imaginary parts, numVectors registers each
+    size_t getSpectrumSize() const noexcept { return 2 * numVectors; }
+
+    size_t numChannels = 0, numPartitions = 0, numVectors = 0;
+    int kernelSize = 0, position = 0;
+
+    //audio side: the last two partitions of input, the next partition of output and the spectra
+    //of the last numPartitions inputs (the frequency domain delay line), all per channel
+    std::vector<float> inputWindows, outputs, fftBuffer, crossfadeBuffer;
+    std::vector<SIMDFloat> delayLine, accumulator;
+    size_t delayLinePosition = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+
+    //the kernels get handed over the same way SnapshotSlot does it, but they're too big to copy on
+    //the audio thread so each side just works on its own slot in place
+    std::array<std::vector<SIMDFloat>, 3> kernels;
+    int designSlot = 0, playSlot = 1;
+    std::atomic<int> spareSlot{ 2 };
+
+    static constexpr int slotMask = 3;
+    static constexpr int freshFlag = 4;
+
+    //design thread side
+    SnapshotSlot<EqCoefficients> requests;
+    std::unique_ptr<juce::dsp::FFT> kernelFft, partitionFft;
+    std::vector<float> kernelBuffer, partitionBuffer, window;
+
+    juce::SharedResourcePointer<DesignThread> designThread;
+    bool registered = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LinearPhaseEq)
+};
@@ -0,0 +1,381 @@
+/*
+  ==============================================================================
+
+    MorphingEq.cpp
+
+  ==============================================================================
+*/
+
+#include "MorphingEq.h"
+
+namespace
+{
+    //the q of each of a butterworth cut's sections, the same ones CoefficientBank designs
+    float getButterworthQ(int section, int numSections) noexcept
+    {
+        auto order = 2.0 * numSections;
+        return (float) (1.0 / (2.0 * std::cos((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (2.0 * order))));
+    }
+
+    float blendOctaves(float a, float b, float amount) noexcept
+    {
+        return a * std::pow(b / a, amount);
+    }
+
+    //pretty much any gain a user instrument could ask for, and still inside where the fast exp is accurate
+    constexpr float maxPeakDecibels = 60.0f;
+}
+
+//==============================================================================
+EqShape EqShape::fromInstrument(const InstrumentEq& eq) noexcept
+{
+    EqShape shape;
+
+    shape.peakFrequency = { { eq.peakOneFreq, eq.peakTwoFreq, eq.peakThreeFreq } };
+    shape.peakQ = { { eq.peakOneQ, eq.peakTwoQ, eq.peakThreeQ } };
+    shape.peakGain = { { eq.peakOneGain, eq.peakTwoGain, eq.peakThreeGain } };
+    shape.lowCutFrequency = eq.cutFreq;
+
+    if (eq.highCutFreq > 0.0f)
+    {
+        shape.highCutFrequency = eq.highCutFreq;
+        shape.highCutAmount = 1.0f;
+    }
+
+    return shape;
+}
+
+EqShape EqShape::blend(const EqShape& a, const EqShape& b, float amount) noexcept
+{
+    EqShape shape;
+
+    for (size_t peak = 0; peak < (size_t) numPeaks; ++peak)
+    {
+        shape.peakFrequency[peak] = blendOctaves(a.peakFrequency[peak], b.peakFrequency[peak], amount);
+        shape.peakQ[peak] = blendOctaves(a.peakQ[peak], b.peakQ[peak], amount);
+        shape.peakGain[peak] = a.peakGain[peak] + amount * (b.peakGain[peak] - a.peakGain[peak]);
+    }
+
+    shape.lowCutFrequency = blendOctaves(a.lowCutFrequency, b.lowCutFrequency, amount);
+
+    //a high cut fading in comes in at its own frequency, rather than sweeping down from wherever "none" is
+    auto highCutA = a.highCutAmount > 0.0f ? a.highCutFrequency : b.highCutFrequency;
+    auto highCutB = b.highCutAmount > 0.0f ? b.highCutFrequency : a.highCutFrequency;
+
+    shape.highCutFrequency = blendOctaves(highCutA, highCutB, amount);
+    shape.highCutAmount = a.highCutAmount + amount * (b.highCutAmount - a.highCutAmount);
+
+    return shape;
+}
+
+EqShape EqShape::forCharacter(float character) noexcept
+{
+    //the built in Kick, Snare and Hi Hat, which sit at 1, 2 and 3 after None
+    auto position = juce::jlimit(0.0f, maxCharacter, character);
+    auto lower = juce::jmin((int) position, (int) maxCharacter - 1);
+
+    auto from = fromInstrument(InstrumentProfiles::builtIn[(size_t) lower + 1].eq);
+    auto to = fromInstrument(InstrumentProfiles::builtIn[(size_t) lower + 2].eq);
+
+    return blend(from, to, position - (float) lower);
+}
+
+EqCoefficients EqShape::getCoefficients(double sampleRate, float slapLevel, int lowCutSlope) const noexcept
+{
+    using Svf = MorphingEq<double>::Svf;
+
+    auto tuning = [sampleRate] (float frequency)
+    {
+        return std::tan(juce::MathConstants<double>::pi * juce::jlimit(10.0, sampleRate * 0.45, (double) frequency) / sampleRate);
+    };
+
+    EqCoefficients eq;
+    BiquadCoefficients* peaks[] = { &eq.peakOne, &eq.peakTwo, &eq.peakThree };
+
+    for (size_t peak = 0; peak < (size_t) numPeaks; ++peak)
+    {
+        auto decibels = juce::jlimit(-maxPeakDecibels, maxPeakDecibels, slapLevel * peakGain[peak]);
+        *peaks[peak] = Svf::bell(tuning(peakFrequency[peak]), peakQ[peak], std::pow(10.0, decibels / 40.0)).toBiquad();
+    }
+
+    eq.lowCut.numSections = juce::jlimit(0, CutCoefficients::maxSections - 1, lowCutSlope) + 1;
+
+    for (int section = 0; section < eq.lowCut.numSections; ++section)
+        eq.lowCut.sections[(size_t) section] = Svf::highPass(tuning(lowCutFrequency), getButterworthQ(section, eq.lowCut.numSections), 1.0).toBiquad();
+
+    if (highCutAmount > 0.0f)
+    {
+        eq.highCut.sections[0] = Svf::lowPass(tuning(highCutFrequency), getButterworthQ(0, 1), highCutAmount).toBiquad();
+        eq.highCut.numSections = 1;
+    }
+
+    return eq;
+}
+
+int EqShape::getLongestDecaySamples(double sampleRate, int lowCutSlope, float decayGain) noexcept
+{
+    //the ends and the middle of the slap range, across CHARACTER in quarter steps so the blends get a look in too
+    constexpr float slapLevels[] = { CoefficientBank::minSlap, 0.0f, CoefficientBank::maxSlap };
+    constexpr int characterStepsPerCurve = 4;
+
+    auto longest = 0;
+
+    for (int step = 0; step <= (int) maxCharacter * characterStepsPerCurve; ++step)
+    {
+        auto shape = forCharacter((float) step / (float) characterStepsPerCurve);
+
+        for (auto slapLevel : slapLevels)
+            longest = juce::jmax(longest, shape.getCoefficients(sampleRate, slapLevel, lowCutSlope).getDecaySamples(decayGain));
+    }
+
+    return longest;
+}
+
+//==============================================================================
+template <typename SampleType>
+typename MorphingEq<SampleType>::Svf MorphingEq<SampleType>::Svf::bell(SampleType g, SampleType q, SampleType gain) noexcept
+{
+    //gain is the linear gain at the centre, square rooted, the same A the RBJ peak uses, which this matches exactly
+    auto k = (SampleType) 1 / (q * gain);
+    auto a1 = (SampleType) 1 / ((SampleType) 1 + g * (g + k));
+
+    return { g, k, (SampleType) 1, k * (gain * gain - (SampleType) 1), (SampleType) 0, a1, g * a1, g * g * a1 };
+}
+
+template <typename SampleType>
+typename MorphingEq<SampleType>::Svf MorphingEq<SampleType>::Svf::highPass(SampleType g, SampleType q, SampleType amount) noexcept
+{
+    //the input minus amount of (band pass * k + low pass), so 0 passes straight through
+    auto k = (SampleType) 1 / q;
+    auto a1 = (SampleType) 1 / ((SampleType) 1 + g * (g + k));
+
+    return { g, k, (SampleType) 1, -amount * k, -amount, a1, g * a1, g * g * a1 };
+}
+
+template <typename SampleType>
+typename MorphingEq<SampleType>::Svf MorphingEq<SampleType>::Svf::lowPass(SampleType g, SampleType q, SampleType amount) noexcept
+{
+    auto k = (SampleType) 1 / q;
+    auto a1 = (SampleType) 1 / ((SampleType) 1 + g * (g + k));
+
+    return { g, k, (SampleType) 1 - amount, (SampleType) 0, amount, a1, g * a1, g * g * a1 };
+}
+
+template <typename SampleType>
+BiquadCoefficients MorphingEq<SampleType>::Svf::toBiquad() const noexcept
+{
+    //the band pass is g (1 - z^-2) / D and the low pass g^2 (1 + z^-1)^2 / D, over the same D
+    auto gd = (double) g, kd = (double) k;
+    auto g2 = gd * gd;
+
+    auto d0 = 1.0 + gd * kd + g2;
+    auto d1 = 2.0 * (g2 - 1.0);
+    auto d2 = 1.0 - gd * kd + g2;
+
+    auto b0 = (double) m0 * d0 + (double) m1 * gd + (double) m2 * g2;
+    auto b1 = (double) m0 * d1 + (double) m2 * 2.0 * g2;
+    auto b2 = (double) m0 * d2 - (double) m1 * gd + (double) m2 * g2;
+
+    return { b0 / d0, b1 / d0, b2 / d0, d1 / d0, d2 / d0 };
+}
+
+//==============================================================================
+template <typename SampleType>
+void MorphingEq<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxNumChannels);
+
+    sampleRate = spec.sampleRate;
+
+    //tan() gets steep up there, and nothing in a drum eq needs to go that high
+    maxFrequency = (float) (sampleRate * 0.45);
+    glideSamples = juce::jmax(1, juce::roundToInt(sampleRate * glideSeconds));
+
+    for (auto& target : targets)
+    {
+        target.frequency.reset(glideSamples);
+        target.q.reset(glideSamples);
+        target.amount.reset(glideSamples);
+    }
+
+    stageActive.fill(false);
+    reset();
+}
+
+template <typename SampleType>
+void MorphingEq<SampleType>::reset() noexcept
+{
+    for (auto& target : targets)
+    {
+        target.frequency.setCurrentAndTargetValue(target.frequency.getTargetValue());
+        target.q.setCurrentAndTargetValue(target.q.getTargetValue());
+        target.amount.setCurrentAndTargetValue(target.amount.getTargetValue());
+    }
+
+    for (size_t stage = 0; stage < numStages; ++stage)
+    {
+        updateSvf(stage, targets[stage].frequency.getCurrentValue(), targets[stage].q.getCurrentValue(), targets[stage].amount.getCurrentValue());
+        states[stage].fill({});
+    }
+
+    glideSamplesRemaining = 0;
+    updateActiveStages();
+}
+
+template <typename SampleType>
+void MorphingEq<SampleType>::setShape(const EqShape& shape, float slapLevel, int lowCutSlope) noexcept
+{
+    auto clampFrequency = [this] (float frequency) { return juce::jlimit(10.0f, maxFrequency, frequency); };
+    auto numLowCutSections = juce::jlimit(0, CutCoefficients::maxSections - 1, lowCutSlope) + 1;
+
+    //the sections past the slope fade out, and keep whatever q they had so they don't sweep on the way
+    for (int section = 0; section < CutCoefficients::maxSections; ++section)
+    {
+        auto& target = targets[(size_t) (LowCut + section)];
+        target.frequency.setTargetValue(clampFrequency(shape.lowCutFrequency));
+
+        if (section < numLowCutSections)
+            target.q.setTargetValue(getButterworthQ(section, numLowCutSections));
+
+        target.amount.setTargetValue(section < numLowCutSections ? 1.0f : 0.0f);
+    }
+
+    for (int peak = 0; peak < EqShape::numPeaks; ++peak)
+    {
+        auto& target = targets[(size_t) (PeakOne + peak)];
+        target.frequency.setTargetValue(clampFrequency(shape.peakFrequency[(size_t) peak]));
+        target.q.setTargetValue(juce::jmax(0.01f, shape.peakQ[(size_t) peak]));
+        target.amount.setTargetValue(juce::jlimit(-maxPeakDecibels, maxPeakDecibels, slapLevel * shape.peakGain[(size_t) peak]));
+    }
+
+    auto& highCut = targets[HighCut];
+    highCut.frequency.setTargetValue(clampFrequency(shape.highCutFrequency));
+    highCut.q.setTargetValue(getButterworthQ(0, 1));
+    highCut.amount.setTargetValue(shape.highCutAmount);
+
+    //everything's on the same length of glide, so it's all settled once this runs out
+    auto gliding = false;
+
+    for (auto& target : targets)
+        gliding = gliding || target.frequency.isSmoothing() || target.q.isSmoothing() || target.amount.isSmoothing();
+
+    if (gliding)
+    {
+        glideSamplesRemaining = glideSamples;
+        updateActiveStages();
+    }
+}
+
+template <typename SampleType>
+void MorphingEq<SampleType>::updateSvf(size_t stage, float frequency, float q, float amount) noexcept
+{
+    //pi * 0.45 is as far up as this ever goes, where the pade tan is still good to about 1e-8
+    auto g = juce::dsp::FastMathApproximations::tan((SampleType) (juce::MathConstants<double>::pi * frequency / sampleRate));
+
+    if (stage >= PeakOne && stage <= PeakThree)
+    {
+        //10^(dB / 40)
+        auto gain = juce::dsp::FastMathApproximations::exp((SampleType) amount * (SampleType) (juce::MathConstants<double>::ln10 / 40.0));
+        svfs[stage] = Svf::bell(g, (SampleType) q, gain);
+    }
+    else if (stage == HighCut)
+    {
+        svfs[stage] = Svf::lowPass(g, (SampleType) q, (SampleType) amount);
+    }
+    else
+    {
+        svfs[stage] = Svf::highPass(g, (SampleType) q, (SampleType) amount);
+    }
+}
+
+template <typename SampleType>
+void MorphingEq<SampleType>::advanceGlide() noexcept
+{
+    for (size_t stage = 0; stage < numStages; ++stage)
+    {
+        auto& target = targets[stage];
+        updateSvf(stage, target.frequency.getNextValue(), target.q.getNextValue(), target.amount.getNextValue());
+    }
+
+    if (--glideSamplesRemaining == 0)
+        updateActiveStages();
+}
+
+template <typename SampleType>
+void MorphingEq<SampleType>::updateActiveStages() noexcept
+{
+    numActiveStages = 0;
+
+    for (size_t stage = 0; stage < numStages; ++stage)
+    {
+        //a cut at 0 and a peak at 0 dB both come out as exactly the input
+        auto& amount = targets[stage].amount;
+        auto active = amount.getCurrentValue() != 0.0f || amount.getTargetValue() != 0.0f;
+
+        if (! active)
+            continue;
+
+        if (! stageActive[stage])
+            states[stage].fill({});
+
+        activeStages[(size_t) numActiveStages++] = (int) stage;
+    }
+
+    for (size_t stage = 0; stage < numStages; ++stage)
+        stageActive[stage] = false;
+
+    for (int i = 0; i < numActiveStages; ++i)
+        stageActive[(size_t) activeStages[(size_t) i]] = true;
+}
+
+template <typename SampleType>
+void MorphingEq<SampleType>::process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    if (bypassed)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto numChannels = juce::jmin(block.getNumChannels(), maxNumChannels);
+    auto numSamples = block.getNumSamples();
+
+    size_t i = 0;
+
+    //while anything's gliding every stage gets retuned before each sample
+    for (; i < numSamples && glideSamplesRemaining > 0; ++i)
+    {
+        advanceGlide();
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* channelData = block.getChannelPointer(ch);
+            auto sample = channelData[i];
+
+            for (int s = 0; s < numActiveStages; ++s)
+            {
+                auto stage = (size_t) activeStages[(size_t) s];
+                sample = states[stage][ch].tick(svfs[stage], sample);
+            }
+
+            channelData[i] = sample;
+        }
+    }
+
+    //then the rest of the block stage by stage, with the tuning standing still
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* channelData = block.getChannelPointer(ch);
+
+        for (int s = 0; s < numActiveStages; ++s)
+        {
+            auto stage = (size_t) activeStages[(size_t) s];
+            auto& svf = svfs[stage];
+            auto& state = states[stage][ch];
+
+            for (auto j = i; j < numSamples; ++j)
+                channelData[j] = state.tick(svf, channelData[j]);
+        }
+    }
+}
+
+template class MorphingEq<float>;
+template class MorphingEq<double>;
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    MorphingEq.h
+
+    The same eq as FilterEngine (the low cut, three peaks and the high cut)
+    but built out of topology preserving state variable filters, so every
+    frequency, Q and gain can move every sample without clicking. Nothing
+    gets designed: each stage's tuning is one tan() (a Pade approximation)
+    and a few multiplies, so it glides to wherever it's told over
+    glideSeconds. That's what the Morph EQ_MODE runs on, where CHARACTER
+    blends between the Kick, Snare and Hi Hat curves. Cuts that aren't
+    there (the low cut's extra sections, a missing high cut) fade in and
+    out rather than switching. It's plain per channel loops, with no
+    interleaving, since it's only retuning while something's gliding.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientBank.h"
+
+//an instrument's eq as frequencies, Qs and gains, which unlike coefficients can be blended and still be a real curve
+struct EqShape
+{
+    static constexpr int numPeaks = 3;
+
+    //gains are dB per dB of slap, the same as InstrumentEq's
+    std::array<float, numPeaks> peakFrequency{ { 1000.0f, 1000.0f, 1000.0f } }, peakQ{ { 0.7071f, 0.7071f, 0.7071f } }, peakGain{};
+    float lowCutFrequency = 20.0f;
+
+    //the high cut fades in rather than switching on, 0 is none of it and 1 is all of it
+    float highCutFrequency = 20000.0f, highCutAmount = 0.0f;
+
+    static EqShape fromInstrument(const InstrumentEq& eq) noexcept;
+
+    //frequencies and Qs move evenly in octaves, the gains in straight lines
+    static EqShape blend(const EqShape& a, const EqShape& b, float amount) noexcept;
+
+    //the CHARACTER range, 0 is the Kick, 1 the Snare and 2 the Hi Hat, anything in between is its two neighbours blended
+    static constexpr float maxCharacter = 2.0f;
+    static EqShape forCharacter(float character) noexcept;
+
+    //the exact curve MorphingEq settles on, as biquads, for drawing it and working out the tail
+    EqCoefficients getCoefficients(double sampleRate, float slapLevel, int lowCutSlope) const noexcept;
+
+    //the longest any CHARACTER and SLAP could ring for at this slope, so the tail can be worked out
+    //once in prepareToPlay instead of designing biquads while it's moving
+    static int getLongestDecaySamples(double sampleRate, int lowCutSlope, float decayGain) noexcept;
+};
+
+//==============================================================================
+template <typename SampleType>
+class MorphingEq
+{
+public:
+    //same as the filter engine, 7.1.4 plus a few spare
+    static constexpr size_t maxNumChannels = 16;
+
+    //how long a change takes to glide in, long enough to not click and short enough to follow automation
+    static constexpr double glideSeconds = 0.05;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    //starts from silence, and jumps straight to the last shape it was given since there's nothing to glide from
+    void reset() noexcept;
+
+    //only sets where everything's headed, so it's cheap enough to call every sub block
+    void setShape(const EqShape& shape, float slapLevel, int lowCutSlope) noexcept;
+    void setBypassed(bool shouldBeBypassed) noexcept { bypassed = shouldBeBypassed; }
+
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    //one stage's tuning, as the cytomic/zavalishin trapezoidal SVF: g = tan(pi f / fs), k = 1 / Q, and the
+    //output is m0 * input + m1 * band pass + m2 * low pass
+    struct Svf
+    {
+        SampleType g, k, m0, m1, m2;
+        SampleType a1, a2, a3;
+
+        static Svf bell(SampleType g, SampleType q, SampleType gain) noexcept;
+        static Svf highPass(SampleType g, SampleType q, SampleType amount) noexcept;
+        static Svf lowPass(SampleType g, SampleType q, SampleType amount) noexcept;
+
+        //the same filter as a normalised biquad, it's an exact match since both are bilinear transforms
+        BiquadCoefficients toBiquad() const noexcept;
+    };
+
+private:
+    enum Stage
+    {
+        LowCut,
+        PeakOne = LowCut + CutCoefficients::maxSections,
+        PeakTwo,
+        PeakThree,
+        HighCut,
+        numStages
+    };
+
+    struct State
+    {
+        SampleType ic1eq{}, ic2eq{};
+
+        SampleType tick(const Svf& svf, SampleType x) noexcept
+        {
+            auto v3 = x - ic2eq;
+            auto v1 = svf.a1 * ic1eq + svf.a2 * v3;
+            auto v2 = ic2eq + svf.a2 * ic1eq + svf.a3 * v3;
+
+            ic1eq = (SampleType) 2 * v1 - ic1eq;
+            ic2eq = (SampleType) 2 * v2 - ic2eq;
+
+            return svf.m0 * x + svf.m1 * v1 + svf.m2 * v2;
+        }
+    };
+
+    //the peaks glide gain in dB and the cuts glide how much of them there is, in the same slot
+    struct StageTarget
+    {
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> frequency{ 1000.0f }, q{ 0.7071f };
+        juce::SmoothedValue<float> amount;
+    };
+
+    //takes every stage one sample further along its glide and retunes it
+    void advanceGlide() noexcept;
+    void updateSvf(size_t stage, float frequency, float q, float amount) noexcept;
+
+    //a stage that's flat and staying flat gets skipped, and reset so it comes back in from silence
+    void updateActiveStages() noexcept;
+
+    std::array<StageTarget, numStages> targets;
+    std::array<Svf, numStages> svfs{};
+    std::array<std::array<State, maxNumChannels>, numStages> states{};
+
+    std::array<int, numStages> activeStages{};
+    std::array<bool, numStages> stageActive{};
+    int numActiveStages = 0;
+
+    double sampleRate = 44100.0;
+    float maxFrequency = 19000.0f;
+    int glideSamples = 0, glideSamplesRemaining = 0;
+    bool bypassed = false;
+
+    JUCE_LEAK_DETECTOR(MorphingEq)
+};
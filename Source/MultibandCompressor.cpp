@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    MultibandCompressor.cpp
+
+  ==============================================================================
+*/
+
+#include "MultibandCompressor.h"
+
+namespace
+{
+    //one normalised biquad for a single lane, designed in double and stored as float
+    struct Section
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    //a 4th order Linkwitz-Riley is two of these at Q = 1/sqrt(2), and the low and high halves add
+    //back up to an allpass with the same poles. all from the bilinear transform, prewarped to frequency
+    Section makeButterworth(double frequency, double sampleRate, bool highPass) noexcept
+    {
+        auto k = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        auto kOverQ = k * juce::MathConstants<double>::sqrt2;
+        auto norm = 1.0 / (1.0 + kOverQ + k * k);
+
+        Section section;
+        section.a1 = 2.0 * (k * k - 1.0) * norm;
+        section.a2 = (1.0 - kOverQ + k * k) * norm;
+
+        if (highPass)
+        {
+            section.b0 = norm;
+            section.b1 = -2.0 * norm;
+        }
+        else
+        {
+            section.b0 = k * k * norm;
+            section.b1 = 2.0 * k * k * norm;
+        }
+
+        section.b2 = section.b0;
+        return section;
+    }
+
+    //what the low band needs so it lines up with the other two once they've been through the second crossover
+    Section makeAllpass(double frequency, double sampleRate) noexcept
+    {
+        auto butterworth = makeButterworth(frequency, sampleRate, false);
+        return { butterworth.a2, butterworth.a1, 1.0, butterworth.a1, butterworth.a2 };
+    }
+
+    constexpr Section passThrough { 1.0, 0.0, 0.0, 0.0, 0.0 };
+    constexpr Section silence { 0.0, 0.0, 0.0, 0.0, 0.0 };
+}
+
+//==============================================================================
+void MultibandCompressor::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels <= maxNumChannels);
+
+    sampleRate = spec.sampleRate;
+    numChannels = juce::jmin((size_t) spec.numChannels, maxNumChannels);
+
+    for (auto& compressor : compressors)
+        compressor.prepare({ spec.sampleRate, spec.maximumBlockSize, 1 });
+
+    //somewhere sensible until the processor sets the instrument's
+    setCrossovers(200.0f, 2000.0f);
+    reset();
+}
+
+void MultibandCompressor::reset() noexcept
+{
+    for (auto& channel : states)
+        for (auto& state : channel)
+            state = { SIMDFloat::expand(0.0f), SIMDFloat::expand(0.0f) };
+
+    for (auto& compressor : compressors)
+        compressor.reset();
+}
+
+void MultibandCompressor::setCrossovers(float lowMidHz, float midHighHz) noexcept
+{
+    //kept below nyquist, and in order
+    auto maxFrequency = sampleRate * 0.45;
+    auto lowMid = juce::jlimit(10.0, maxFrequency, (double) lowMidHz);
+    auto midHigh = juce::jlimit(lowMid, maxFrequency, (double) midHighHz);
+
+    auto lowPassOne = makeButterworth(lowMid, sampleRate, false), highPassOne = makeButterworth(lowMid, sampleRate, true);
+    auto lowPassTwo = makeButterworth(midHigh, sampleRate, false), highPassTwo = makeButterworth(midHigh, sampleRate, true);
+
+    //[stage][band], any lanes past the bands are silent from the first stage on
+    const Section design[numStages][numBands]
+    {
+        { lowPassOne, highPassOne, highPassOne },
+        { lowPassOne, highPassOne, highPassOne },
+        { makeAllpass(midHigh, sampleRate), lowPassTwo, highPassTwo },
+        { passThrough, lowPassTwo, highPassTwo }
+    };
+
+    for (size_t stage = 0; stage < numStages; ++stage)
+    {
+        auto& biquad = stages[stage];
+
+        for (size_t lane = 0; lane < SIMDFloat::size(); ++lane)
+        {
+            auto& section = lane < (size_t) numBands ? design[stage][lane] : (stage == 0 ? silence : passThrough);
+
+            biquad.b0.set(lane, (float) section.b0);
+            biquad.b1.set(lane, (float) section.b1);
+            biquad.b2.set(lane, (float) section.b2);
+            biquad.a1.set(lane, (float) section.a1);
+            biquad.a2.set(lane, (float) section.a2);
+        }
+    }
+}
+
+void MultibandCompressor::setBandThreshold(Band band, float newThresholdDecibels) noexcept
+{
+    forEachCompressor([&] (SlapsCompressor& compressor) { compressor.setLaneThreshold((size_t) band, newThresholdDecibels); });
+}
+
+void MultibandCompressor::setRatio(float newRatio) noexcept
+{
+    forEachCompressor([&] (SlapsCompressor& compressor) { compressor.setRatio(newRatio); });
+}
+
+void MultibandCompressor::setAttack(float newAttackMs) noexcept
+{
+    forEachCompressor([&] (SlapsCompressor& compressor) { compressor.setAttack(newAttackMs); });
+}
+
+void MultibandCompressor::setRelease(float newReleaseMs) noexcept
+{
+    forEachCompressor([&] (SlapsCompressor& compressor) { compressor.setRelease(newReleaseMs); });
+}
+
+void MultibandCompressor::setKnee(float newKneeDecibels) noexcept
+{
+    forEachCompressor([&] (SlapsCompressor& compressor) { compressor.setKnee(newKneeDecibels); });
+}
+
+template <typename SampleType>
+void MultibandCompressor::process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    auto channels = juce::jmin(block.getNumChannels(), numChannels);
+
+    for (size_t channel = 0; channel < channels; ++channel)
+        processChannel(block.getChannelPointer(channel), block.getNumSamples(), channel);
+}
+
+template <typename SampleType>
+void MultibandCompressor::processChannel(SampleType* data, size_t numSamples, size_t channel) noexcept
+{
+    auto& state = states[channel];
+    auto& compressor = compressors[channel];
+    auto* lanes = reinterpret_cast<float*>(chunk.data());
+    constexpr auto numLanes = SIMDFloat::size();
+
+    for (size_t start = 0; start < numSamples; start += chunkSize)
+    {
+        auto numInChunk = juce::jmin(chunkSize, numSamples - start);
+
+        //every band's filters at once, the sample goes into every lane and each lane keeps its own band
+        for (size_t i = 0; i < numInChunk; ++i)
+        {
+            auto x = SIMDFloat::expand((float) data[start + i]);
+
+            for (size_t stage = 0; stage < numStages; ++stage)
+            {
+                auto& c = stages[stage];
+                auto& s = state[stage];
+
+                auto y = c.b0 * x + s.s1;
+                s.s1 = c.b1 * x - c.a1 * y + s.s2;
+                s.s2 = c.b2 * x - c.a2 * y;
+                x = y;
+            }
+
+            chunk[i] = x;
+        }
+
+        //each band gets its own threshold from its lane
+        compressor.processInterleaved(lanes, numInChunk, 0);
+
+        for (size_t i = 0; i < numInChunk; ++i)
+        {
+            auto* bands = lanes + i * numLanes;
+            data[start + i] = (SampleType) (bands[low] + bands[mid] + bands[high]);
+        }
+    }
+}
+
+template void MultibandCompressor::process<float>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void MultibandCompressor::process<double>(const juce::dsp::ProcessContextReplacing<double>&) noexcept;
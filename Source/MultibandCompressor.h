@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    MultibandCompressor.h
+
+    The multiband slap: every channel gets split into low, mid and high
+    with 4th order Linkwitz-Riley crossovers, each band gets compressed on
+    its own and then they're summed back. The low band also goes through
+    the high crossover's allpass, so all three come back with the same
+    phase and the sum stays flat. The bands sit side by side in one
+    SIMDRegister, each lane with its own coefficients, so the whole split
+    is two cascades of two biquads and the compressor does all three bands
+    in one interleaved pass, which costs about the same as one band.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SlapsCompressor.h"
+
+class MultibandCompressor
+{
+public:
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+
+    enum Band { low, mid, high, numBands };
+
+    static constexpr size_t maxNumChannels = SlapsCompressor::maxNumChannels;
+    static_assert(numBands <= (int) SlapsCompressor::numLanes, "each band needs a lane of its own");
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    //both just work coefficients out in place, so they're fine on the audio thread
+    void setCrossovers(float lowMidHz, float midHighHz) noexcept;
+    void setBandThreshold(Band band, float newThresholdDecibels) noexcept;
+
+    //the same for every band
+    void setRatio(float newRatio) noexcept;
+    void setAttack(float newAttackMs) noexcept;
+    void setRelease(float newReleaseMs) noexcept;
+    void setKnee(float newKneeDecibels) noexcept;
+
+    int getReleaseSamples(float decayGain) const noexcept { return compressors[0].getReleaseSamples(decayGain); }
+
+    //the split and the compressors run in float, the same as SlapsCompressor's gain does in double
+    template <typename SampleType>
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+private:
+    //transposed direct form II, a different filter in every lane
+    struct Biquad
+    {
+        SIMDFloat b0, b1, b2, a1, a2;
+    };
+
+    struct BiquadState
+    {
+        SIMDFloat s1, s2;
+    };
+
+    //two sections at the low/mid crossover and then two at the mid/high one
+    static constexpr size_t numStages = 4;
+
+    //the interleaved buffer the compressor works on, in chunks so it can live in here and never allocate
+    static constexpr size_t chunkSize = 64;
+
+    template <typename SampleType>
+    void processChannel(SampleType* data, size_t numSamples, size_t channel) noexcept;
+
+    //the compressor settings all go to every channel's compressor
+    template <typename Function>
+    void forEachCompressor(Function&& function) noexcept
+    {
+        for (auto& compressor : compressors)
+            function(compressor);
+    }
+
+    double sampleRate = 44100.0;
+    size_t numChannels = 0;
+
+    std::array<Biquad, numStages> stages;
+    std::array<std::array<BiquadState, numStages>, maxNumChannels> states;
+
+    //one per channel, with the bands in its lanes
+    std::array<SlapsCompressor, maxNumChannels> compressors;
+
+    std::array<SIMDFloat, chunkSize> chunk;
+
+    JUCE_LEAK_DETECTOR(MultibandCompressor)
+};
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    ParameterState.h
+
+    The binary layout getStateInformation writes: a small header and then
+    every parameter as a plain little endian float, in its own units, in a
+    fixed order. Reading it back is a bounds check and a loop, with no XML
+    or ValueTree in between, which adds up with hundreds of instances in a
+    session. Blobs that don't start with the magic number are left for the
+    old XML path, so sessions saved before this still load.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class ParameterState
+{
+public:
+    //"SLPS" as it sits in the file, then which layout this is and how many values follow
+    static constexpr juce::uint32 magic = 0x53504c53;
+    static constexpr juce::uint32 version = 1;
+    static constexpr size_t headerSize = 3 * sizeof(juce::uint32);
+
+    //the order the values go in. new parameters only ever go on the end, so an older blob just stops
+    //early and the extra values from a newer build get skipped. version only goes up if a slot changes meaning
+    static constexpr std::array<const char*, 18> parameterIDs
+    {{
+        "GAIN", "SLAP", "RATIO", "ATTACK", "RELEASE", "KNEE", "BYPASS", "INSTRUMENT",
+        "OVERSAMPLING", "OVERSAMPLING_MODE", "EQ_MODE",
+        "MULTIBAND", "SLAP_LOW", "SLAP_MID", "SLAP_HIGH", "MIX", "LOW_CUT_SLOPE", "CHARACTER"
+    }};
+
+    static constexpr size_t numParameters = parameterIDs.size();
+    using Values = std::array<float, numParameters>;
+
+    static void write(const Values& values, juce::MemoryBlock& dest)
+    {
+        dest.setSize(headerSize + numParameters * sizeof(juce::uint32));
+        auto* out = static_cast<char*>(dest.getData());
+
+        writeInt(out, magic);
+        writeInt(out + 4, version);
+        writeInt(out + 8, (juce::uint32) numParameters);
+
+        for (size_t i = 0; i < numParameters; ++i)
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, &values[i], sizeof(bits));
+            writeInt(out + headerSize + i * sizeof(bits), bits);
+        }
+    }
+
+    //how many values were read into the front of values, or -1 if this isn't one of ours
+    static int read(const void* data, int sizeInBytes, Values& values) noexcept
+    {
+        if (data == nullptr || sizeInBytes < (int) headerSize)
+            return -1;
+
+        auto* in = static_cast<const char*>(data);
+
+        if (juce::ByteOrder::littleEndianInt(in) != magic || juce::ByteOrder::littleEndianInt(in + 4) != version)
+            return -1;
+
+        auto numStored = (size_t) juce::ByteOrder::littleEndianInt(in + 8);
+
+        if ((size_t) sizeInBytes < headerSize + numStored * sizeof(juce::uint32))
+            return -1;
+
+        auto numToRead = juce::jmin(numStored, numParameters);
+
+        for (size_t i = 0; i < numToRead; ++i)
+        {
+            auto bits = juce::ByteOrder::littleEndianInt(in + headerSize + i * sizeof(juce::uint32));
+            std::memcpy(&values[i], &bits, sizeof(bits));
+        }
+
+        return (int) numToRead;
+    }
+
+private:
+    static void writeInt(char* dest, juce::uint32 value) noexcept
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(dest, &value, sizeof(value));
+    }
+};
@@ -11,57 +11,106 @@
 
 //==============================================================================
 SlapsAudioProcessorEditor::SlapsAudioProcessorEditor (SlapsAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), spectrumDisplay (p), audioProcessor (p)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (500, 300);
-    startTimerHz(48);
+    setSize (500, controlsHeight + 160);
+    setOpaque(true);
+    setTimerRate(activeHz);
 
     //Show our Gain Slider
     gainSlider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
     gainSlider.setTextBoxStyle(juce::Slider::NoTextBox, true, 100, 25);
     gainSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts, "GAIN", gainSlider);
-    gainSlider.addListener(this);
     addAndMakeVisible(gainSlider);
 
     //Show our One Knob
     slapKnob.setSliderStyle(juce::Slider::SliderStyle::Rotary);
     slapKnob.setTextBoxStyle(juce::Slider::NoTextBox, true, 100, 25);
     slapKnobAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts, "SLAP", slapKnob);
-    slapKnob.addListener(this);
     addAndMakeVisible(slapKnob);
 
     //Show our Drop Down List
     addAndMakeVisible(instrType);
-    instrType.addItem ("None", 1);
-    instrType.addItem("Kick", 2);
-    instrType.addItem("Snare", 3);
-    instrType.addItem("Hi-Hat", 4);
-    instrType.onChange = [this] { instrumentChanged(); };
+    instrType.addItemList(audioProcessor.apvts.getParameter("INSTRUMENT")->getAllValueStrings(), 1);
+
+    //the slots past the user's file are only there to keep the choice count fixed
+    for (int slot = audioProcessor.instrumentProfiles->size(); slot < InstrumentProfiles::maxNumInstruments; ++slot)
+        instrType.setItemEnabled(slot + 1, false);
     instrumentAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "INSTRUMENT", instrType);
+
+    //oversampling factor and which filters it uses
+    addAndMakeVisible(oversamplingBox);
+    oversamplingBox.addItemList(audioProcessor.apvts.getParameter("OVERSAMPLING")->getAllValueStrings(), 1);
+    oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "OVERSAMPLING", oversamplingBox);
+
+    addAndMakeVisible(oversamplingModeBox);
+    oversamplingModeBox.addItemList(audioProcessor.apvts.getParameter("OVERSAMPLING_MODE")->getAllValueStrings(), 1);
+    oversamplingModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "OVERSAMPLING_MODE", oversamplingModeBox);
+
+    //minimum or linear phase eq, or morphing
+    addAndMakeVisible(eqModeBox);
+    eqModeBox.addItemList(audioProcessor.apvts.getParameter("EQ_MODE")->getAllValueStrings(), 1);
+    eqModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "EQ_MODE", eqModeBox);
+
+    //how steep the low cut is
+    addAndMakeVisible(lowCutSlopeBox);
+    lowCutSlopeBox.addItemList(audioProcessor.apvts.getParameter("LOW_CUT_SLOPE")->getAllValueStrings(), 1);
+    lowCutSlopeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "LOW_CUT_SLOPE", lowCutSlopeBox);
  
 
+    //little compressor knobs down the left, the value pops up while you drag them
+    auto setUpCompressorKnob = [this] (juce::Slider& knob, const juce::String& parameterID,
+                                       std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>& attachment)
+    {
+        knob.setSliderStyle(juce::Slider::SliderStyle::Rotary);
+        knob.setTextBoxStyle(juce::Slider::NoTextBox, true, 50, 20);
+        knob.setPopupDisplayEnabled(true, true, this);
+        attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts, parameterID, knob);
+        addAndMakeVisible(knob);
+    };
+
+    setUpCompressorKnob(ratioKnob, "RATIO", ratioAttachment);
+    setUpCompressorKnob(attackKnob, "ATTACK", attackAttachment);
+    setUpCompressorKnob(releaseKnob, "RELEASE", releaseAttachment);
+    setUpCompressorKnob(kneeKnob, "KNEE", kneeAttachment);
+
+    //multiband, and how much more or less slap each band gets
+    multibandButton.setButtonText("Multiband");
+    addAndMakeVisible(multibandButton);
+    multibandAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "MULTIBAND", multibandButton);
+
+    setUpCompressorKnob(lowSlapKnob, "SLAP_LOW", lowSlapAttachment);
+    setUpCompressorKnob(midSlapKnob, "SLAP_MID", midSlapAttachment);
+    setUpCompressorKnob(highSlapKnob, "SLAP_HIGH", highSlapAttachment);
+
+    //dry/wet, for parallel slap without a second bus
+    setUpCompressorKnob(mixKnob, "MIX", mixAttachment);
+
+    //kick to snare to hi hat, for the morph eq mode
+    setUpCompressorKnob(characterKnob, "CHARACTER", characterAttachment);
+
     //show our bypass button
     addAndMakeVisible(pluginBypassButton);
     bypassAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "BYPASS", pluginBypassButton);
-    pluginBypassButton.onClick = [this] {bypassButtonToggleState(pluginBypassButton.getToggleState()); };
 
     //show our peak level label
     addAndMakeVisible(peakLabel);
     peakLabel.setColour(juce::Label::backgroundColourId, juce::Colours::black);
     peakLabel.attachToComponent(&gainSlider, false);
 
-    //image time baby
-    auto logoImage = juce::ImageCache::getFromMemory(BinaryData::Logo_png, BinaryData::Logo_pngSize);
-    if (!logoImage.isNull()) 
-    {
-        mImageComponent.setImage(logoImage, juce::RectanglePlacement::stretchToFit);
-    }
-    else {
-        jassert (! logoImage.isNull());
-    }
-    addAndMakeVisible(mImageComponent);
+    //how hard processBlock is working, average and 99th percentile
+    addAndMakeVisible(dspLoadLabel);
+    dspLoadLabel.setJustificationType(juce::Justification::centredRight);
+    dspLoadLabel.setFont(juce::Font(12.0f));
+
+    //input, output and the instrument's eq curve
+    addAndMakeVisible(spectrumDisplay);
+
+    //image time baby, it gets drawn into the background
+    logoImage = juce::ImageCache::getFromMemory(BinaryData::Logo_png, BinaryData::Logo_pngSize);
+    jassert (! logoImage.isNull());
  
 
 
@@ -74,6 +123,24 @@ SlapsAudioProcessorEditor::~SlapsAudioProcessorEditor()
 //==============================================================================
 void SlapsAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    //drawn at the display's real resolution, so it only needs redoing if the window moves to a different screen
+    auto scale = (float) g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (background.isNull() || scale != backgroundScale)
+        renderBackground(scale);
+
+    g.drawImageTransformed(background, juce::AffineTransform::scale(1.0f / backgroundScale));
+}
+
+void SlapsAudioProcessorEditor::renderBackground(float scale)
+{
+    backgroundScale = scale;
+    background = juce::Image(juce::Image::RGB, juce::jmax(1, juce::roundToInt((float) getWidth() * scale)),
+                             juce::jmax(1, juce::roundToInt((float) getHeight() * scale)), false);
+
+    juce::Graphics g(background);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll(juce::Colours::slategrey);
 
@@ -82,9 +149,10 @@ void SlapsAudioProcessorEditor::paint (juce::Graphics& g)
     g.setColour(juce::Colours::black);
     g.drawText("SLAPS", getLocalBounds(), juce::Justification::centredTop, true);
 
-
-
-
+    //the logo, placed relative to the controls so the analyser underneath doesn't move it
+    auto bounds = getLocalBounds().withHeight(controlsHeight).toFloat();
+    g.drawImage(logoImage, { bounds.getWidth() * 0.23f, bounds.getHeight() * 0.23f, bounds.getWidth() * 0.03f, bounds.getHeight() * 0.055f },
+                juce::RectanglePlacement::stretchToFit);
 }
 
 void SlapsAudioProcessorEditor::resized()
@@ -101,29 +169,46 @@ void SlapsAudioProcessorEditor::resized()
     //Instrument Type Box
     instrType.setBounds(390, 10, 100, 50);
 
+    //oversampling boxes, under the instrument box
+    oversamplingBox.setBounds(390, 65, 100, 25);
+    oversamplingModeBox.setBounds(285, 65, 100, 25);
+
+    //eq mode, next to them
+    eqModeBox.setBounds(180, 65, 100, 25);
+
+    //low cut slope under the gain slider, clear of the logo and the peak label
+    lowCutSlopeBox.setBounds(75, 262, 100, 25);
+
     //bypass button
     pluginBypassButton.setBounds(10, 10, 50, 50);
 
+    //compressor knobs
+    ratioKnob.setBounds(10, 70, 50, 50);
+    attackKnob.setBounds(10, 125, 50, 50);
+    releaseKnob.setBounds(10, 180, 50, 50);
+    kneeKnob.setBounds(10, 235, 50, 50);
+
+    //multiband down the right, low to high
+    multibandButton.setBounds(405, 95, 90, 25);
+    highSlapKnob.setBounds(420, 125, 50, 50);
+    midSlapKnob.setBounds(420, 180, 50, 50);
+    lowSlapKnob.setBounds(420, 235, 50, 50);
+
+    //mix, between the gain and the big knob
+    mixKnob.setBounds(175, 200, 50, 50);
+
+    //character above it
+    characterKnob.setBounds(175, 130, 50, 50);
+
     //peak Label
     peakLabel.setBounds(112, 75, 25, 25);
 
-    //image
-    mImageComponent.setBoundsRelative(0.23f, .23f, 0.03f, 0.055f);
+    spectrumDisplay.setBounds(10, controlsHeight, getWidth() - 20, 130);
+    dspLoadLabel.setBounds(getWidth() - 160, getHeight() - 25, 150, 20);
 
-}
+    //the background gets redrawn at the new size next time we paint
+    background = {};
 
-void SlapsAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
-{
-    if (slider == &gainSlider)
-    {
-        audioProcessor.rawVolume = pow(10, gainSlider.getValue() / 20);
-
-    }
-    if (slider == &slapKnob)
-    {
-        audioProcessor.slapLevel = slapKnob.getValue();
-        audioProcessor.volumeSlap = pow(10, slapKnob.getValue() / 60);
-    }
 }
 
 //this is the function that lets things change in the gui
@@ -135,39 +220,97 @@ void SlapsAudioProcessorEditor::timerCallback()
 
     }
 
-    //change the peak value color on screen
-    if (audioProcessor.peakLevel >= -0.5)
+    auto dspLoadWindow = audioProcessor.dspLoad.getNumWindows();
+
+    if (dspLoadWindow != lastDspLoadWindow)
+    {
+        lastDspLoadWindow = dspLoadWindow;
+        auto stats = audioProcessor.dspLoad.getStats();
+        dspLoadLabel.setText("DSP " + juce::String(stats.averagePercent, 1) + "% / p99 " + juce::String(stats.p99Percent, 1) + "%",
+                             juce::dontSendNotification);
+    }
+
+    //the meters are per channel, the label just shows whichever channel going into the compressor is loudest
+    auto& meters = audioProcessor.meters;
+    auto rms = 0.0f, peak = 0.0f;
+
+    for (int channel = 0; channel < meters.getNumChannels(); ++channel)
     {
+        rms = juce::jmax(rms, meters.getRms(LevelMeters::input, channel));
+        peak = juce::jmax(peak, meters.takePeak(LevelMeters::input, channel));
+    }
+
+    auto peakLevel = juce::Decibels::gainToDecibels(rms);
+
+    //hang on to peaks for a bit so a single hit still lights the label up
+    auto peakDecibels = juce::Decibels::gainToDecibels(peak);
 
-        peakLabel.setColour(juce::Label::backgroundColourId, juce::Colours::red);
+    if (peakDecibels >= heldPeakLevel)
+    {
+        heldPeakLevel = peakDecibels;
+        peakHoldFramesLeft = peakHoldFrames;
     }
-    else if (audioProcessor.peakLevel > -6 )
+    else if (peakHoldFramesLeft > 0)
     {
-        if (peakLabel.findColour(juce::Label::backgroundColourId) == juce::Colours::red)
-        {
-            peakLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkred);
-        }
-        else
-        {
-            //peakLabel.setText(std::to_string(audioProcessor.peakLevel), juce::sendNotification);
-            peakLabel.setColour(juce::Label::backgroundColourId, juce::Colours::green);
-        }
+        --peakHoldFramesLeft;
     }
     else
     {
-        if (peakLabel.findColour(juce::Label::backgroundColourId) == juce::Colours::green)
-        {
-            peakLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgreen);
-        }
-        else if (peakLabel.findColour(juce::Label::backgroundColourId) == juce::Colours::red)
-        {
-            peakLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkred);
-        }
-        else 
-        {
-            peakLabel.setText("", juce::sendNotification);
-            peakLabel.setColour(juce::Label::backgroundColourId, juce::Colours::black);
-        }
+        heldPeakLevel = peakDecibels;
+    }
+
+    //the label only gets touched when it actually changes colour, so a steady level never repaints anything
+    auto nextColour = getNextPeakColour(heldPeakLevel, peakLevel);
+
+    if (nextColour != peakColour)
+    {
+        peakColour = nextColour;
+        peakLabel.setColour(juce::Label::backgroundColourId, getColour(peakColour));
+    }
+
+    //nothing to show while we're hidden, or once the input's gone quiet and the label's settled back to black.
+    //still ticking slowly though, so we notice when either of those stops being true
+    auto silent = heldPeakLevel < silenceDecibels && peakColour == PeakColour::off;
+    setTimerRate(isShowing() && ! silent ? activeHz : idleHz);
+}
+
+SlapsAudioProcessorEditor::PeakColour SlapsAudioProcessorEditor::getNextPeakColour(float heldPeakDecibels, float rmsDecibels) const noexcept
+{
+    //red for a clip, green while it's loud, and each fades through its dark version on the way back to black
+    if (heldPeakDecibels >= -0.5f)
+        return PeakColour::red;
+
+    if (rmsDecibels > -6.0f)
+        return peakColour == PeakColour::red ? PeakColour::darkRed : PeakColour::green;
+
+    if (peakColour == PeakColour::green)
+        return PeakColour::darkGreen;
+
+    if (peakColour == PeakColour::red)
+        return PeakColour::darkRed;
+
+    return PeakColour::off;
+}
+
+juce::Colour SlapsAudioProcessorEditor::getColour(PeakColour colour) noexcept
+{
+    switch (colour)
+    {
+        case PeakColour::green:     return juce::Colours::green;
+        case PeakColour::darkGreen: return juce::Colours::darkgreen;
+        case PeakColour::red:       return juce::Colours::red;
+        case PeakColour::darkRed:   return juce::Colours::darkred;
+        case PeakColour::off:       break;
     }
 
-}
\ No newline at end of file
+    return juce::Colours::black;
+}
+
+void SlapsAudioProcessorEditor::setTimerRate(int hz)
+{
+    if (hz != timerHz)
+    {
+        timerHz = hz;
+        startTimerHz(hz);
+    }
+}
@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumDisplay.h"
 
 
 
@@ -17,7 +18,7 @@
 /**
 */
 class SlapsAudioProcessorEditor  : public juce::AudioProcessorEditor,
-    public juce::Slider::Listener, public juce::Timer
+    public juce::Timer
 {
 public:
     SlapsAudioProcessorEditor (SlapsAudioProcessor&);
@@ -26,46 +27,77 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
-    void sliderValueChanged(juce::Slider* slider) override;
     void timerCallback() override;
     
 
 
 private:
  
+    //the background, title and logo never change, so they get drawn once into here and just copied after that
+    void renderBackground(float scale);
+
+    juce::Image background;
+    float backgroundScale = 0.0f;
+    juce::Image logoImage;
+
+    //the peak label only ever shows one of these, and only gets repainted when it moves to a different one
+    enum class PeakColour { off, green, darkGreen, red, darkRed };
+    PeakColour getNextPeakColour(float heldPeakDecibels, float rmsDecibels) const noexcept;
+    static juce::Colour getColour(PeakColour colour) noexcept;
+
+    PeakColour peakColour = PeakColour::off;
+
+    //the timer slows right down when there's nothing to show, and speeds back up when there is
+    void setTimerRate(int hz);
+
+    static constexpr int activeHz = 48, idleHz = 4;
+    static constexpr float silenceDecibels = -90.0f;
+
+    //the knobs and boxes all sit in the top part, the analyser goes underneath
+    static constexpr int controlsHeight = 300;
+    int timerHz = 0;
+
 
     //where we create our sliders and such
     juce::Slider gainSlider;
     juce::Slider slapKnob;
     juce::ComboBox instrType;
+    juce::ComboBox oversamplingBox, oversamplingModeBox;
+    juce::ComboBox eqModeBox;
+    juce::ComboBox lowCutSlopeBox;
+    juce::Slider ratioKnob, attackKnob, releaseKnob, kneeKnob;
+    juce::ToggleButton multibandButton;
+    juce::Slider lowSlapKnob, midSlapKnob, highSlapKnob;
+    juce::Slider mixKnob;
+    juce::Slider characterKnob;
     juce::ToggleButton pluginBypassButton;
     juce::Label peakLabel;
-    juce::ImageComponent mImageComponent;
+    juce::Label dspLoadLabel;
+    SpectrumDisplay spectrumDisplay;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> slapKnobAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> bypassAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> instrumentAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> eqModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> lowCutSlopeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ratioAttachment, attackAttachment, releaseAttachment, kneeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> multibandAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> lowSlapAttachment, midSlapAttachment, highSlapAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> characterAttachment;
 
     int framesElapsed = 0;
 
-    //quick function to set the instrument variable to equal the instrument combobox value
-    void instrumentChanged()
-    {
-        switch (instrType.getSelectedId())
-        {
-        case 1: audioProcessor.instrument = 1; break;
-        case 2: audioProcessor.instrument = 2; break;
-        case 3: audioProcessor.instrument = 3; break;
-        case 4: audioProcessor.instrument = 4; break;
-        default: break;
-        }
-    }
-
-    void bypassButtonToggleState(bool bypassValue)
-    {
-        audioProcessor.pluginBypassed = bypassValue;
-    }
+    //peak hold for the peak label, about a second at 48 frames a second
+    static constexpr int peakHoldFrames = activeHz;
+    float heldPeakLevel = -100.0f;
+    int peakHoldFramesLeft = 0;
+
+    //the dsp load label only gets new text when the meter's finished another window
+    int lastDspLoadWindow = 0;
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
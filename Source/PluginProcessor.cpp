@@ -7,7 +7,11 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+
+//the headless render tool builds the processor on its own, without the editor or its resources
+#if ! SLAPS_HEADLESS
+ #include "PluginEditor.h"
+#endif
 
 //==============================================================================
 SlapsAudioProcessor::SlapsAudioProcessor()
@@ -22,11 +26,38 @@ SlapsAudioProcessor::SlapsAudioProcessor()
                        ), apvts (*this, nullptr, "Parameters", createParameters())
 #endif
 {
+    gainParameter = apvts.getRawParameterValue("GAIN");
+    slapParameter = apvts.getRawParameterValue("SLAP");
+    mixParameter = apvts.getRawParameterValue("MIX");
+    characterParameter = apvts.getRawParameterValue("CHARACTER");
+
+    for (size_t i = 0; i < ParameterState::numParameters; ++i)
+    {
+        stateParameters[i] = apvts.getParameter(ParameterState::parameterIDs[i]);
+        jassert(stateParameters[i] != nullptr);
+    }
+
+    //every parameter change gets picked up here and handed on to the audio thread
+    for (auto* param : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.addParameterListener(withID->paramID, this);
+
+    auto logFile = DspLoadLog::getFileFromEnvironment();
+
+    if (logFile != juce::File())
+        dspLoadLog = std::make_unique<DspLoadLog>(dspLoad, logFile);
 
+    //only does anything when a parameter that moves the latency has changed
+    startTimerHz(30);
 }
 
 SlapsAudioProcessor::~SlapsAudioProcessor()
 {
+    for (auto* param : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.removeParameterListener(withID->paramID, this);
+
+    stopTimer();
 }
 
 //==============================================================================
@@ -64,7 +95,7 @@ bool SlapsAudioProcessor::isMidiEffect() const
 
 double SlapsAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailSeconds.load(std::memory_order_relaxed);
 }
 
 int SlapsAudioProcessor::getNumPrograms()
@@ -98,47 +129,136 @@ void SlapsAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 
     juce::dsp::ProcessSpec spec;
 
-    spec.maximumBlockSize = samplesPerBlock;
+    //hosts don't always stick to what they said here, processSamples never hands anything a bigger chunk than this
+    preparedBlockSize = juce::jmax(1, samplesPerBlock);
+    spec.maximumBlockSize = (juce::uint32) preparedBlockSize;
 
     spec.numChannels = getTotalNumOutputChannels();
 
     spec.sampleRate = sampleRate;
 
+    for (int factor = 0; factor < numOversamplingFactors; ++factor)
+    {
+        auto& path = paths[(size_t) factor];
+
+        //each path runs at the oversampled rate, on oversampled sized blocks
+        auto pathSpec = spec;
+        pathSpec.sampleRate = sampleRate * (1 << factor);
+        pathSpec.maximumBlockSize = spec.maximumBlockSize << factor;
+
+        //the compressor's settings all get set in applyChainSettings
+        path.compressor.prepare(pathSpec);
+        path.multiband.prepare(pathSpec);
 
-    //prep compressor
-    compressor.prepare(spec);
+        withActiveFilterEngine(path, [&pathSpec] (auto& filterEngine) { filterEngine.prepare(pathSpec); });
+        withActiveMorphingEq(path, [&pathSpec] (auto& morphingEq) { morphingEq.prepare(pathSpec); });
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+        //every coefficient we could need, designed up front so processBlock only has to copy floats.
+        //only the first instance at each rate actually designs anything, the rest share its bank
+        path.coefficientBank = CoefficientBank::getShared(pathSpec.sampleRate, instrumentProfiles.get());
 
-    auto instrument = "bass";
+        for (int slope = 0; slope < CoefficientBank::numLowCutSlopes; ++slope)
+            path.morphDecaySamples[(size_t) slope] = EqShape::getLongestDecaySamples(pathSpec.sampleRate, slope, silenceThreshold);
+    }
 
-    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 63.f, 1.0541f, juce::Decibels::decibelsToGain(0));
+    //drop whatever the other precision had, so nothing goes looking at oversamplers we aren't using
+    oversamplers = {};
 
-    leftChain.get<ChainPositions::PeakOne>().coefficients = *peakCoefficients;
-    rightChain.get<ChainPositions::PeakOne>().coefficients = *peakCoefficients;
+    if (isUsingDoublePrecision())
+        prepareOversamplers<double>(spec);
+    else
+        prepareOversamplers<float>(spec);
+
+    //gain and slap start out where they are, no ramping in from wherever they were last time
+    smoothedGain.reset(sampleRate, smoothingSeconds);
+    smoothedGain.setCurrentAndTargetValue(gainParameter->load());
+    smoothedSlap.reset(sampleRate, smoothingSeconds);
+    smoothedSlap.setCurrentAndTargetValue(slapParameter->load());
+    smoothedMix.reset(sampleRate, smoothingSeconds);
+    smoothedMix.setCurrentAndTargetValue(mixParameter->load() / 100.0f);
+    character = characterParameter->load();
+    characterShape = EqShape::forCharacter(character);
+
+    //the audio thread isn't running yet so we can just set everything up directly
+    chainSettingsChanged.store(false);
+    chainSettings = getChainSettings(chainParameters, *instrumentProfiles);
+    activeOversampling = chainSettings.oversampling;
+    activeOversamplingMode = chainSettings.oversamplingMode;
+
+    //the linear phase eq always gets made, so turning it on later doesn't have to wait for anything
+    requestedKernel = getLinearPhaseKernelId();
+    linearPhaseEq.prepare(spec, getLinearPhaseTarget());
+    linearPhaseActive = chainSettings.linearPhaseEq;
+    multibandActive = chainSettings.multiband;
+    morphActive = chainSettings.morphEq;
+
+    //room for the longest the wet signal could ever be held up, so changing modes never has to grow it
+    auto maxLatency = getMaxProcessingLatency();
+    dryDelays = {};
+    withActiveDryDelay([&spec, maxLatency] (auto& dryDelay) { dryDelay.prepare((int) spec.numChannels, (int) spec.maximumBlockSize, maxLatency); });
+
+    applyChainSettings();
+    updateLatency(chainSettings);
+
+    //and the morphing eq starts out on its curve rather than gliding in from wherever it was
+    withActiveMorphingEq(paths[(size_t) activeOversampling], [] (auto& morphingEq) { morphingEq.reset(); });
+
+    dspLoad.prepare(sampleRate);
+    analyser.prepare(sampleRate);
 
-    auto peakTwoCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 433.f, 0.866f, juce::Decibels::decibelsToGain(0));
+    // Use this method as the place to do any pre-playback
+    // initialisation that you need..
+}
 
-    leftChain.get<ChainPositions::PeakTwo>().coefficients = *peakTwoCoefficients;
-    rightChain.get<ChainPositions::PeakTwo>().coefficients = *peakTwoCoefficients;
+template <typename SampleType>
+void SlapsAudioProcessor::prepareOversamplers(const juce::dsp::ProcessSpec& spec)
+{
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
 
-    auto peakThreeCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), 5477.f, 0.782464f, juce::Decibels::decibelsToGain(0));
+    //economy is the cheap polyphase IIR for tracking, linear phase is the FIR one for mixdown
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        auto filterType = mode == 0 ? Oversampler::filterHalfBandPolyphaseIIR
+                                    : Oversampler::filterHalfBandFIREquiripple;
 
-    leftChain.get<ChainPositions::PeakThree>().coefficients = *peakThreeCoefficients;
-    rightChain.get<ChainPositions::PeakThree>().coefficients = *peakThreeCoefficients;
+        for (int factor = 1; factor < numOversamplingFactors; ++factor)
+        {
+            auto& oversampler = std::get<OversamplerSet<SampleType>>(oversamplers)[(size_t) mode][(size_t) factor - 1];
+            oversampler = std::make_unique<Oversampler>(spec.numChannels, (size_t) factor, filterType, true, true);
 
-    //low cut filter info
-    auto cutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(20.f, sampleRate, 2);
+            //pads the filters' fractional delay up to a whole sample, so the latency the host and the dry
+            //delay get told is exactly what the wet signal has
+            oversampler->setUsingIntegerLatency(true);
+            oversampler->initProcessing(spec.maximumBlockSize);
+        }
+    }
+}
 
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
+template <typename Function>
+void SlapsAudioProcessor::withActiveFilterEngine(ProcessingPath& path, Function&& function)
+{
+    if (isUsingDoublePrecision())
+        function(path.getFilterEngine<double>());
+    else
+        function(path.getFilterEngine<float>());
+}
 
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
+template <typename Function>
+void SlapsAudioProcessor::withActiveMorphingEq(ProcessingPath& path, Function&& function)
+{
+    if (isUsingDoublePrecision())
+        function(path.getMorphingEq<double>());
+    else
+        function(path.getMorphingEq<float>());
+}
 
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
+template <typename Function>
+void SlapsAudioProcessor::withActiveDryDelay(Function&& function)
+{
+    if (isUsingDoublePrecision())
+        function(getDryDelay<double>());
+    else
+        function(getDryDelay<float>());
 }
 
 void SlapsAudioProcessor::releaseResources()
@@ -155,11 +275,11 @@ bool SlapsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
     return true;
   #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Anything from mono up to 16 channels works (stereo, LCR, 5.1, 7.1.4, discrete...),
+    // every channel gets the same eq and compressor with its own state.
+    auto& mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput.isDisabled() || mainOutput.size() > (int) FilterEngine<float>::maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -173,8 +293,28 @@ bool SlapsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
 }
 #endif
 
-void SlapsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void SlapsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer);
+}
+
+void SlapsAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer);
+}
+
+bool SlapsAudioProcessor::supportsDoublePrecisionProcessing() const
 {
+    return true;
+}
+
+template <typename SampleType>
+void SlapsAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    //anything in here that allocates or locks gets reported when SLAPS_RT_CHECKS is on
+    const RealtimeChecks::ScopedAudioThread audioThread;
+    const DspLoadMeter::ScopedTimer loadTimer(dspLoad, buffer.getNumSamples());
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -188,222 +328,632 @@ void SlapsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    auto chainSettings = getChainSettings(apvts);
-    rawVolume = chainSettings.gainKnob;
-    slapLevel = chainSettings.slapLevel;
-    volumeSlap = chainSettings.volumeSlap;
+    //only bother updating the compressor and eq when something's actually changed. it's all loads and
+    //copies out of the bank, so automation lands on the very next block without going near the message thread
+    if (chainSettingsChanged.exchange(false, std::memory_order_acquire))
+    {
+        chainSettings = getChainSettings(chainParameters, *instrumentProfiles);
+        applyChainSettings();
+    }
+
+    //gain and slap get ramped to wherever the host has them now
+    smoothedGain.setTargetValue(gainParameter->load(std::memory_order_relaxed));
+    smoothedSlap.setTargetValue(slapParameter->load(std::memory_order_relaxed));
+    smoothedMix.setTargetValue(mixParameter->load(std::memory_order_relaxed) / 100.0f);
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
+    //the morphing eq glides to the new curve on its own, so it only needs telling where CHARACTER's gone
+    auto newCharacter = characterParameter->load(std::memory_order_relaxed);
+
+    if (newCharacter != character)
+    {
+        character = newCharacter;
+        characterShape = EqShape::forCharacter(character);
+
+        if (chainSettings.morphEq)
+            applySlap(smoothedSlap.getCurrentValue());
+    }
+
+    if (chainSettings.linearPhaseEq)
+        requestLinearPhaseKernel();
+
+    auto numChannels = buffer.getNumChannels();
+    auto numSamples = buffer.getNumSamples();
+    //the fused kernel is float only and has the IIR eq built in, anything else goes through the stages one by one
+    auto useFused = useFusedKernel.load(std::memory_order_relaxed) && chainSettings.oversampling == 0
+                 && ! chainSettings.linearPhaseEq && ! chainSettings.morphEq && ! chainSettings.multiband;
+
+    analyser.push(SpectrumAnalyser::input, buffer, totalNumInputChannels);
+
+    //nothing coming in and everything's finished ringing, so there's nothing to do
+    if (isSilent(buffer))
+    {
+        silentSamples = juce::jmin(silentSamples + numSamples, std::numeric_limits<int>::max() / 2);
+
+        //only once this whole block is past the tail, anything still ringing into it has to be processed
+        if (silentSamples - numSamples >= tailSamples)
+        {
+            processIdle(buffer);
+            analyser.push(SpectrumAnalyser::output, buffer, totalNumInputChannels);
+            return;
+        }
+    }
+    else
+    {
+        silentSamples = 0;
+        idle = false;
+    }
+
+    blockLevels.clear();
+
+    for (int start = 0; start < numSamples;)
+    {
+        //while anything's ramping we go a short sub block at a time, so the threshold and eq can follow
+        //the ramp for the price of one update per sub block. once it settles the rest goes in as few chunks
+        //as fit in the block size we were prepared for, everything downstream only has room for that much
+        auto ramping = smoothedGain.isSmoothing() || smoothedSlap.isSmoothing() || smoothedMix.isSmoothing();
+        auto numInChunk = juce::jmin(ramping ? smoothingSubBlockSize : preparedBlockSize, numSamples - start);
+
+        auto gainStart = smoothedGain.getCurrentValue(), slapStart = smoothedSlap.getCurrentValue();
+        auto gainEnd = smoothedGain.skip(numInChunk), slapEnd = smoothedSlap.skip(numInChunk);
+        auto mixStart = smoothedMix.getCurrentValue(), mixEnd = smoothedMix.skip(numInChunk);
+
+        if (slapEnd != slapStart)
+            applySlap(slapEnd);
+
+        auto inputGain = GainRamp::between(juce::Decibels::decibelsToGain(gainStart), juce::Decibels::decibelsToGain(gainEnd), numInChunk);
+        auto outputGain = GainRamp::between(getOutputGain(gainStart, slapStart), getOutputGain(gainEnd, slapEnd), numInChunk);
+
+        //points at the same channel data, no copying
+        juce::AudioBuffer<SampleType> chunk(buffer.getArrayOfWritePointers(), numChannels, start, numInChunk);
+
+        //the dry copy goes in before anything touches the chunk, even when it's all wet, so turning
+        //MIX down never reads stale input
+        auto& dryDelay = getDryDelay<SampleType>();
+        dryDelay.write(chunk);
+
+        if constexpr (std::is_same<SampleType, float>::value)
+        {
+            if (useFused)
+                processFused(chunk, inputGain, outputGain);
+            else
+                processStaged(chunk, inputGain, outputGain);
+        }
+        else
+        {
+            processStaged(chunk, inputGain, outputGain);
+        }
+
+        //the meters have already had the wet signal, which is what the other knobs are changing
+        if (mixStart < 1.0f || mixEnd < 1.0f)
+            dryDelay.mixInto(chunk, mixStart, mixEnd);
+
+        start += numInChunk;
+    }
+
+    meters.push(blockLevels, numChannels, numSamples);
+    analyser.push(SpectrumAnalyser::output, buffer, totalNumInputChannels);
+}
+
+//the tail is below -120 dB by now, so zero the dsp state once (which is as good as having run the silence
+//through it) and from then on just output silence, keeping the ramps moving so nothing jumps when sound comes back
+template <typename SampleType>
+void SlapsAudioProcessor::processIdle(juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    auto numSamples = buffer.getNumSamples();
+
+    if (! idle)
+    {
+        auto& path = paths[(size_t) activeOversampling];
+        path.compressor.reset();
+        path.multiband.reset();
+        path.getFilterEngine<SampleType>().reset();
+        path.getMorphingEq<SampleType>().reset();
+
+        if (auto* oversampler = getOversampler<SampleType>(chainSettings))
+            oversampler->reset();
+
+        linearPhaseEq.reset();
+        getDryDelay<SampleType>().reset();
+        idle = true;
+    }
+
+    buffer.clear();
+
+    smoothedGain.skip(numSamples);
+    smoothedMix.skip(numSamples);
+
+    if (smoothedSlap.isSmoothing())
+        applySlap(smoothedSlap.skip(numSamples));
+
+    blockLevels.clear();
+    meters.push(blockLevels, buffer.getNumChannels(), numSamples);
+}
+
+template <typename SampleType>
+bool SlapsAudioProcessor::isSilent(const juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel), buffer.getNumSamples());
+
+        if (range.getEnd() >= (SampleType) silenceThreshold || range.getStart() <= (SampleType) -silenceThreshold)
+            return false;
+    }
+
+    return true;
+}
+
+//runs each stage over the whole buffer in turn, and is the only path that can oversample
+template <typename SampleType>
+void SlapsAudioProcessor::processStaged(juce::AudioBuffer<SampleType>& buffer, GainRamp inputGain, GainRamp outputGain) noexcept
+{
+    auto numChannels = buffer.getNumChannels();
 
     //Deal with the gain first 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    for (int channel = 0; channel < numChannels; ++channel)
     {
         auto* channelData = buffer.getWritePointer (channel);
 
-        // ..do something to the data...
         for (int sample = 0; sample < buffer.getNumSamples(); sample++)
         {
-            channelData[sample] = buffer.getSample(channel, sample) * rawVolume;
+            channelData[sample] = channelData[sample] * (SampleType) inputGain.at(sample);
 
         }
     }
 
-
-    
-    auto block = juce::dsp::AudioBlock<float>(buffer);
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+    auto block = juce::dsp::AudioBlock<SampleType>(buffer);
     
-    //set the peak level to be used for the indicator
-    peakLevel = juce::Decibels::gainToDecibels(buffer.getRMSLevel(0, 0, buffer.getNumSamples()));
+    //measure every channel for the meters as we go
+    for (int channel = 0; channel < numChannels; ++channel)
+        blockLevels.measure(LevelMeters::input, channel, buffer.getReadPointer(channel), buffer.getNumSamples());
 
+    //the compressor and eq run at the oversampled rate if it's turned on
+    auto& path = paths[(size_t) activeOversampling];
+    auto* oversampler = getOversampler<SampleType>(chainSettings);
+    auto processingBlock = oversampler != nullptr ? oversampler->processSamplesUp(block) : block;
+    auto context = juce::dsp::ProcessContextReplacing<SampleType>(processingBlock);
 
     //Now compress the signal
 
-    if (pluginBypassed == false)
+    if (chainSettings.bypass == false)
     {
-        compressor.setRatio(10.0);
-        compressor.setAttack(40);
-        compressor.setRelease(200);
-        compressor.setThreshold(slapLevel * -0.5);
-        compressor.process(context);
+        if (chainSettings.multiband)
+            path.multiband.process(context);
+        else
+            path.compressor.process(context);
     }
     else {}
 
-    //now we get into eq stuff
-    //setting the values for each instrument. I'm dumb, so 1 = none, 2 = kick, 3 = snare, 4 = hihat
-    if (instrument == 2)
+    //scaled back down so the RMS comes out per original sample
+    auto oversampledSamples = (int) processingBlock.getNumSamples();
+    auto sumScale = (float) buffer.getNumSamples() / (float) juce::jmax(1, oversampledSamples);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        blockLevels.measure(LevelMeters::postCompressor, channel, processingBlock.getChannelPointer((size_t) channel), oversampledSamples, sumScale);
+
+    //now we get into eq stuff, the coefficients were already set up in applySlap
+    //this runs left and right (and any other channels) through the same filters together
+    if (chainSettings.morphEq)
+        path.getMorphingEq<SampleType>().process(context);
+    else if (! chainSettings.linearPhaseEq)
+        path.getFilterEngine<SampleType>().process(context);
+
+    if (oversampler != nullptr)
+        oversampler->processSamplesDown(block);
+
+    //the linear phase eq doesn't alias so it runs at the host rate, once the oversampling is done with
+    if (chainSettings.linearPhaseEq)
+        linearPhaseEq.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+
+    //this part sets the volume back to normal from the initial gain slider, plus the slap makeup
+    for (int channel = 0; channel < numChannels; ++channel)
     {
-        peakOneFreq = 63.f;
-        peakOneQ = 1.0541f;
-        peakTwoFreq = 433.f;
-        peakTwoQ = 0.866f;
-        peakThreeFreq = 5477.f;
-        peakThreeQ = 0.782464f;
-        cutFreq = 20.f;
+        auto* channelData = buffer.getWritePointer(channel);
+
+        for (int sample = 0; sample < buffer.getNumSamples(); sample++)
+        {
+            channelData[sample] = channelData[sample] * (SampleType) outputGain.at(sample);
+
+        }
     }
-    
-    else if (instrument == 3)
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        blockLevels.measure(LevelMeters::output, channel, buffer.getReadPointer(channel), buffer.getNumSamples());
+}
+
+//does exactly what processStaged does without oversampling, in the same order and with the same maths,
+//but one tile at a time so the samples only get pulled through the cache once
+void SlapsAudioProcessor::processFused(juce::AudioBuffer<float>& buffer, GainRamp inputGain, GainRamp outputGain) noexcept
+{
+    auto numChannels = (size_t) buffer.getNumChannels();
+    auto numSamples = buffer.getNumSamples();
+
+    jassert(numChannels <= FilterEngine<float>::maxNumChannels);
+
+    if (numSamples <= 0)
+        return;
+
+    //no oversampling in here, so always the 1x path
+    auto& path = paths[0];
+    auto& filterEngine = path.getFilterEngine<float>();
+    auto lanes = FilterEngine<float>::numLanes;
+    static_assert(SlapsCompressor::numLanes == FilterEngine<float>::numLanes, "the compressor works on the filter engine's interleaved buffer");
+    auto tileSize = juce::jmin(fusedTileSize, (int) filterEngine.getMaxInterleavedSamples());
+
+    auto compress = chainSettings.bypass == false;
+
+    for (int start = 0; start < numSamples; start += tileSize)
     {
-        peakOneFreq = 137.f;
-        peakOneQ = 0.979796f;
-        peakTwoFreq = 600.f;
-        peakTwoQ = 1.2f;
-        peakThreeFreq = 7746.f;
-        peakThreeQ = 0.704179f;
-        cutFreq = 75.f;
+        auto numInTile = juce::jmin(tileSize, numSamples - start);
+
+        //gain and meter straight into the interleaved buffer
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* channelData = buffer.getReadPointer((int) ch, start);
+            auto* wide = filterEngine.getChannelData(ch);
+
+            auto inputPeak = 0.0f, inputSum = 0.0f;
+
+            for (int i = 0; i < numInTile; ++i)
+            {
+                auto sample = channelData[i] * inputGain.at(start + i);
+
+                inputPeak = juce::jmax(inputPeak, std::abs(sample));
+                inputSum += sample * sample;
+
+                wide[(size_t) i * lanes] = sample;
+            }
+
+            blockLevels.add(LevelMeters::input, (int) ch, inputPeak, inputSum);
+        }
+
+        //the compressor takes the same interleaved layout, so it does a whole group of channels at once
+        if (compress)
+            for (size_t firstChannel = 0; firstChannel < numChannels; firstChannel += lanes)
+                path.compressor.processInterleaved(filterEngine.getChannelData(firstChannel), (size_t) numInTile, firstChannel);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* wide = filterEngine.getChannelData(ch);
+
+            auto compressedPeak = 0.0f, compressedSum = 0.0f;
+
+            for (int i = 0; i < numInTile; ++i)
+            {
+                auto sample = wide[(size_t) i * lanes];
+
+                compressedPeak = juce::jmax(compressedPeak, std::abs(sample));
+                compressedSum += sample * sample;
+            }
+
+            blockLevels.add(LevelMeters::postCompressor, (int) ch, compressedPeak, compressedSum);
+        }
+
+        filterEngine.processInterleaved((size_t) numInTile);
+
+        //then back out with the output gain on the way
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* channelData = buffer.getWritePointer((int) ch, start);
+            auto* wide = filterEngine.getChannelData(ch);
+
+            auto outputPeak = 0.0f, outputSum = 0.0f;
+
+            for (int i = 0; i < numInTile; ++i)
+            {
+                auto sample = wide[(size_t) i * lanes] * outputGain.at(start + i);
+
+                outputPeak = juce::jmax(outputPeak, std::abs(sample));
+                outputSum += sample * sample;
+
+                channelData[i] = sample;
+            }
+
+            blockLevels.add(LevelMeters::output, (int) ch, outputPeak, outputSum);
+        }
     }
+}
 
-    else if (instrument == 4)
+//runs on the audio thread whenever a new set of settings arrives, so no allocating in here
+void SlapsAudioProcessor::applyChainSettings()
+{
+    //the morphing eq gets started from silence after applySlap below, so it starts on its new curve too
+    auto restartMorphingEq = false;
+
+    //changing oversampling means switching to another path, so start it and its oversampler from silence
+    if (chainSettings.oversampling != activeOversampling || chainSettings.oversamplingMode != activeOversamplingMode)
     {
-        peakOneFreq = 387.f;
-        peakOneQ = 1.9365f;
-        peakTwoFreq = 200.f;
-        peakTwoQ = 0.866f;
-        peakThreeFreq = 10000.f;
-        peakThreeQ = 0.6666667f;
-        cutFreq = 275.f;
+        restartMorphingEq = true;
+
+        activeOversampling = chainSettings.oversampling;
+        activeOversamplingMode = chainSettings.oversamplingMode;
+
+        paths[(size_t) activeOversampling].compressor.reset();
+        paths[(size_t) activeOversampling].multiband.reset();
+        withActiveFilterEngine(paths[(size_t) activeOversampling], [] (auto& filterEngine) { filterEngine.reset(); });
+
+        resetActiveOversampler();
     }
 
-    else if (instrument == 1)
+    //the dry has to come out as late as the wet does, whatever just changed
+    auto latency = getProcessingLatency(chainSettings);
+    withActiveDryDelay([latency] (auto& dryDelay) { dryDelay.setDelay(latency); });
+
+    //and going in or out of multiband, the one taking over shouldn't pick up an old envelope
+    if (chainSettings.multiband != multibandActive)
     {
-        peakOneFreq = 387.f;
-        peakOneQ = 1.9365f;
-        peakTwoFreq = 200.f;
-        peakTwoQ = 0.866f;
-        peakThreeFreq = 10000.f;
-        peakThreeQ = 0.6666667f;
-        cutFreq = 20.f;
+        multibandActive = chainSettings.multiband;
+
+        paths[(size_t) activeOversampling].compressor.reset();
+        paths[(size_t) activeOversampling].multiband.reset();
     }
-    //stop the eq if 
-    if (instrument == 1)
 
+    //same for switching between the IIR, linear phase and morphing eqs, whichever one takes over starts from silence
+    if (chainSettings.linearPhaseEq != linearPhaseActive || chainSettings.morphEq != morphActive)
     {
-        auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), peakOneFreq, peakOneQ, juce::Decibels::decibelsToGain(0));
+        linearPhaseActive = chainSettings.linearPhaseEq;
+        morphActive = chainSettings.morphEq;
+        restartMorphingEq = true;
 
+        linearPhaseEq.reset();
+        withActiveFilterEngine(paths[(size_t) activeOversampling], [] (auto& filterEngine) { filterEngine.reset(); });
+    }
 
-        leftChain.get<ChainPositions::PeakOne>().coefficients = *peakCoefficients;
-        rightChain.get<ChainPositions::PeakOne>().coefficients = *peakCoefficients;
+    auto& path = paths[(size_t) activeOversampling];
 
-        auto peakTwoCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), peakTwoFreq, peakTwoQ, juce::Decibels::decibelsToGain(0));
+    path.compressor.setRatio(chainSettings.ratio);
+    path.compressor.setAttack(chainSettings.attackMs);
+    path.compressor.setRelease(chainSettings.releaseMs);
+    path.compressor.setKnee(chainSettings.kneeDecibels);
 
+    path.multiband.setRatio(chainSettings.ratio);
+    path.multiband.setAttack(chainSettings.attackMs);
+    path.multiband.setRelease(chainSettings.releaseMs);
+    path.multiband.setKnee(chainSettings.kneeDecibels);
 
-        leftChain.get<ChainPositions::PeakTwo>().coefficients = *peakTwoCoefficients;
-        rightChain.get<ChainPositions::PeakTwo>().coefficients = *peakTwoCoefficients;
+    auto& instrumentEq = instrumentProfiles->getEq(chainSettings.instrument);
+    path.multiband.setCrossovers(instrumentEq.lowCrossover, instrumentEq.highCrossover);
 
-        auto peakThreeCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), peakThreeFreq, peakThreeQ, juce::Decibels::decibelsToGain(0));
+    auto bypass = chainSettings.bypass;
+    withActiveFilterEngine(path, [bypass] (auto& filterEngine) { filterEngine.setBypassed(bypass); });
+    withActiveMorphingEq(path, [bypass] (auto& morphingEq) { morphingEq.setBypassed(bypass); });
 
+    //the instrument or the path might have changed, so the eq needs redoing even if slap hasn't moved
+    applySlap(smoothedSlap.getCurrentValue());
 
-        leftChain.get<ChainPositions::PeakThree>().coefficients = *peakThreeCoefficients;
-        rightChain.get<ChainPositions::PeakThree>().coefficients = *peakThreeCoefficients;
-    }
-    //use the eq otherwise
-    else {
-        //these three sets set each of the peak filters to do what they gotta do
-        auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), peakOneFreq, peakOneQ, juce::Decibels::decibelsToGain(slapLevel * 0.3));
+    if (restartMorphingEq)
+        withActiveMorphingEq(path, [] (auto& morphingEq) { morphingEq.reset(); });
+}
 
-        leftChain.setBypassed <ChainPositions::PeakOne>(pluginBypassed);
-        rightChain.setBypassed <ChainPositions::PeakOne>(pluginBypassed);
-        leftChain.get<ChainPositions::PeakOne>().coefficients = *peakCoefficients;
-        rightChain.get<ChainPositions::PeakOne>().coefficients = *peakCoefficients;
+//everything that follows the slap knob apart from the makeup, which gets ramped along with the gain.
+//the eq is blended between the two nearest designs in the bank, so it moves smoothly without designing anything.
+//in morph mode the morphing eq just gets told where to glide to instead
+void SlapsAudioProcessor::applySlap(float slapLevel) noexcept
+{
+    auto& path = paths[(size_t) activeOversampling];
 
-        auto peakTwoCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), peakTwoFreq, peakTwoQ, juce::Decibels::decibelsToGain(slapLevel * -0.2));
+    path.compressor.setThreshold(slapLevel * -0.5f);
 
-        leftChain.setBypassed <ChainPositions::PeakTwo>(pluginBypassed);
-        rightChain.setBypassed <ChainPositions::PeakTwo>(pluginBypassed);
-        leftChain.get<ChainPositions::PeakTwo>().coefficients = *peakTwoCoefficients;
-        rightChain.get<ChainPositions::PeakTwo>().coefficients = *peakTwoCoefficients;
+    if (chainSettings.multiband)
+        for (int band = 0; band < MultibandCompressor::numBands; ++band)
+            path.multiband.setBandThreshold((MultibandCompressor::Band) band, (slapLevel + chainSettings.bandSlapOffsets[(size_t) band]) * -0.5f);
 
-        auto peakThreeCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), peakThreeFreq, peakThreeQ, juce::Decibels::decibelsToGain(slapLevel * 0.25));
+    if (chainSettings.morphEq)
+    {
+        auto slope = chainSettings.lowCutSlope;
+        withActiveMorphingEq(path, [&] (auto& morphingEq) { morphingEq.setShape(characterShape, slapLevel, slope); });
 
-        leftChain.setBypassed <ChainPositions::PeakThree>(pluginBypassed);
-        rightChain.setBypassed <ChainPositions::PeakThree>(pluginBypassed);
-        leftChain.get<ChainPositions::PeakThree>().coefficients = *peakThreeCoefficients;
-        rightChain.get<ChainPositions::PeakThree>().coefficients = *peakThreeCoefficients;
+        //the worst case over every curve it could be on, so nothing gets designed while it moves
+        updateTail(path.morphDecaySamples[(size_t) slope]);
+        return;
     }
 
-    //low cut filter info
-    auto cutCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(cutFreq, getSampleRate(), 2);
+    auto eq = path.coefficientBank->getInterpolated(chainSettings.instrument, slapLevel, chainSettings.lowCutSlope);
 
-    leftChain.setBypassed <ChainPositions::LowCut>(pluginBypassed);
-    rightChain.setBypassed <ChainPositions::LowCut>(pluginBypassed);
+    withActiveFilterEngine(path, [&eq] (auto& filterEngine) { filterEngine.setCoefficients(eq); });
 
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    *leftLowCut.get<0>().coefficients = *cutCoefficients[0];
+    updateTail(eq.getDecaySamples(silenceThreshold));
+}
+
+//how long after the input goes silent until the output (and the compressor's envelope) is below -120 dB
+void SlapsAudioProcessor::updateTail(int eqDecaySamples) noexcept
+{
+    auto& path = paths[(size_t) activeOversampling];
 
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    *rightLowCut.get<0>().coefficients = *cutCoefficients[0];
+    //bypassed means the eq and compressor aren't running, so only the oversampling delay is left
+    juce::int64 ringing = 0;
 
+    if (! chainSettings.bypass)
+        ringing = juce::jmax(chainSettings.linearPhaseEq ? (juce::int64) 0 : (juce::int64) eqDecaySamples,
+                             (juce::int64) path.compressor.getReleaseSamples(silenceThreshold));
 
-    //juce::dsp::AudioBlock<float> block(buffer);
-    //and these lines basically get the eq into the signal, replacing the old version
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    //those are at the oversampled rate, the latency isn't
+    auto factor = (juce::int64) 1 << activeOversampling;
+    ringing = (ringing + factor - 1) / factor;
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    //the linear phase eq is at the host rate already, and rings for half its kernel after the latency
+    if (chainSettings.linearPhaseEq)
+        ringing += linearPhaseEq.getTailSamples();
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
-    
-    double chainVolume;
-    if (pluginBypassed == false)
+    auto latency = (juce::int64) getProcessingLatency(chainSettings);
+
+    tailSamples = (int) juce::jmin(ringing + latency, (juce::int64) std::numeric_limits<int>::max() / 4);
+
+    auto sampleRate = getSampleRate();
+    tailSeconds.store(sampleRate > 0 ? (double) tailSamples / sampleRate : 0.0, std::memory_order_relaxed);
+}
+
+//undoes the input gain, and adds the slap makeup (10^(slap/60)) unless we're bypassed
+float SlapsAudioProcessor::getOutputGain(float gainDecibels, float slapLevel) const noexcept
+{
+    auto makeupDecibels = chainSettings.bypass ? 0.0f : slapLevel / 3.0f;
+    return juce::Decibels::decibelsToGain(makeupDecibels - gainDecibels);
+}
+
+template <typename SampleType>
+juce::dsp::Oversampling<SampleType>* SlapsAudioProcessor::getOversampler(const ChainSettings& settings) const noexcept
+{
+    if (settings.oversampling <= 0)
+        return nullptr;
+
+    return std::get<OversamplerSet<SampleType>>(oversamplers)[(size_t) settings.oversamplingMode][(size_t) settings.oversampling - 1].get();
+}
+
+void SlapsAudioProcessor::resetActiveOversampler() noexcept
+{
+    if (isUsingDoublePrecision())
     {
-        chainVolume = rawVolume / volumeSlap;
+        if (auto* oversampler = getOversampler<double>(chainSettings))
+            oversampler->reset();
     }
-    else
+    else if (auto* oversampler = getOversampler<float>(chainSettings))
     {
-        chainVolume = rawVolume;
+        oversampler->reset();
     }
+}
 
-    //this part sets the volume back to normal from the initial gain slider, and in the future will also do the auto makeup gain from the compressor
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer(channel);
+//only the oversamplers for the precision we're running at get made, so ask whichever those are.
+//it's a whole number of samples already, every oversampler's set to integer latency
+int SlapsAudioProcessor::getOversamplingLatency(const ChainSettings& settings) const noexcept
+{
+    if (auto* oversampler = getOversampler<float>(settings))
+        return juce::roundToInt(oversampler->getLatencyInSamples());
 
-        // ..do something to the data...
-        for (int sample = 0; sample < buffer.getNumSamples(); sample++)
-        {
-            channelData[sample] = buffer.getSample(channel, sample) / chainVolume;
+    if (auto* oversampler = getOversampler<double>(settings))
+        return juce::roundToInt(oversampler->getLatencyInSamples());
 
-        }
-    }
+    return 0;
+}
 
+int SlapsAudioProcessor::getProcessingLatency(const ChainSettings& settings) const noexcept
+{
+    return getOversamplingLatency(settings) + (settings.linearPhaseEq ? linearPhaseEq.getLatencySamples() : 0);
+}
+
+int SlapsAudioProcessor::getMaxProcessingLatency() const noexcept
+{
+    ChainSettings settings;
+    settings.linearPhaseEq = true;
+
+    auto maxLatency = 0;
+
+    for (settings.oversamplingMode = 0; settings.oversamplingMode < 2; ++settings.oversamplingMode)
+        for (settings.oversampling = 0; settings.oversampling < numOversamplingFactors; ++settings.oversampling)
+            maxLatency = juce::jmax(maxLatency, getProcessingLatency(settings));
+
+    return maxLatency;
+}
+
+//the oversampling filters and the linear phase eq are the only things that delay the signal, let the host know how much
+void SlapsAudioProcessor::updateLatency(const ChainSettings& settings)
+{
+    setLatencySamples(getProcessingLatency(settings));
+}
+
+//which bank entry the linear phase eq should be on, -1 being bypassed
+int SlapsAudioProcessor::getLinearPhaseKernelId() const noexcept
+{
+    if (chainSettings.bypass)
+        return -1;
+
+    auto curve = chainSettings.lowCutSlope * instrumentProfiles->size() + chainSettings.instrument;
+    return curve * CoefficientBank::numSlapSteps + CoefficientBank::getSlapIndex(smoothedSlap.getTargetValue());
+}
+
+EqCoefficients SlapsAudioProcessor::getLinearPhaseTarget() const noexcept
+{
+    //bypassed it's just a delay, so the latency stays put and the host's compensation doesn't jump
+    if (chainSettings.bypass)
+        return {};
+
+    //designed at the host rate, so always from the 1x bank
+    return paths[0].coefficientBank->get(chainSettings.instrument, smoothedSlap.getTargetValue(), chainSettings.lowCutSlope);
+}
+
+//audio thread, only asks the design thread for anything when the target's actually moved
+void SlapsAudioProcessor::requestLinearPhaseKernel() noexcept
+{
+    auto kernelId = getLinearPhaseKernelId();
+
+    if (kernelId == requestedKernel)
+        return;
+
+    requestedKernel = kernelId;
+    linearPhaseEq.requestKernel(getLinearPhaseTarget());
+}
+
+//parameter changes can come in on any thread, so this never posts messages or locks, it just raises the flags.
+//gain, slap, mix and character get read straight off the parameters in processBlock, so they don't need to go this way
+void SlapsAudioProcessor::parameterChanged(const juce::String& parameterID, float)
+{
+    if (parameterID == "GAIN" || parameterID == "SLAP" || parameterID == "MIX" || parameterID == "CHARACTER")
+        return;
+
+    chainSettingsChanged.store(true, std::memory_order_release);
+    latencyChanged.store(true, std::memory_order_release);
+}
+
+//the host has to be told about latency from the message thread, which is the only thing left that can't be done per block
+void SlapsAudioProcessor::timerCallback()
+{
+    if (latencyChanged.exchange(false, std::memory_order_acquire))
+        updateLatency(getChainSettings(chainParameters, *instrumentProfiles));
 }
 
 //==============================================================================
 bool SlapsAudioProcessor::hasEditor() const
 {
+   #if SLAPS_HEADLESS
+    return false;
+   #else
     return true; // (change this to false if you choose to not supply an editor)
+   #endif
 }
 
 juce::AudioProcessorEditor* SlapsAudioProcessor::createEditor()
 {
+   #if SLAPS_HEADLESS
+    return nullptr;
+   #else
     return new SlapsAudioProcessorEditor (*this);
     //return new juce::GenericAudioProcessorEditor(*this);
+   #endif
 }
 
 //==============================================================================
 void SlapsAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    //every parameter in its own units, so a range changing later doesn't move anything
+    ParameterState::Values values;
+
+    for (size_t i = 0; i < ParameterState::numParameters; ++i)
+        values[i] = stateParameters[i]->convertFrom0to1(stateParameters[i]->getValue());
+
+    ParameterState::write(values, destData);
 }
 
 
 
 void SlapsAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    ParameterState::Values values;
+    auto numValues = ParameterState::read(data, sizeInBytes, values);
+
+    if (numValues >= 0)
+    {
+        //anything an older blob didn't have goes to its default, same as a fresh instance
+        for (size_t i = 0; i < ParameterState::numParameters; ++i)
+        {
+            auto* param = stateParameters[i];
+            auto stored = (int) i < numValues && std::isfinite(values[i]);
+
+            param->setValueNotifyingHost(stored ? param->convertTo0to1(values[i]) : param->getDefaultValue());
+        }
+
+        return;
+    }
+
+    //sessions saved before the binary format had the whole parameter tree as XML
     std::unique_ptr<juce::XmlElement> theParams(getXmlFromBinary(data, sizeInBytes));
 
     if (theParams != nullptr)
@@ -426,16 +976,42 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new SlapsAudioProcessor();
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+ChainParameters::ChainParameters(juce::AudioProcessorValueTreeState& apvts)
+    : bypass(apvts.getRawParameterValue("BYPASS")), instrument(apvts.getRawParameterValue("INSTRUMENT")),
+      oversampling(apvts.getRawParameterValue("OVERSAMPLING")), oversamplingMode(apvts.getRawParameterValue("OVERSAMPLING_MODE")),
+      eqMode(apvts.getRawParameterValue("EQ_MODE")), lowCutSlope(apvts.getRawParameterValue("LOW_CUT_SLOPE")),
+      ratio(apvts.getRawParameterValue("RATIO")), attack(apvts.getRawParameterValue("ATTACK")),
+      release(apvts.getRawParameterValue("RELEASE")), knee(apvts.getRawParameterValue("KNEE")),
+      multiband(apvts.getRawParameterValue("MULTIBAND"))
+{
+    bandSlapOffsets[MultibandCompressor::low] = apvts.getRawParameterValue("SLAP_LOW");
+    bandSlapOffsets[MultibandCompressor::mid] = apvts.getRawParameterValue("SLAP_MID");
+    bandSlapOffsets[MultibandCompressor::high] = apvts.getRawParameterValue("SLAP_HIGH");
+}
+
+ChainSettings getChainSettings(const ChainParameters& parameters, const InstrumentProfiles& profiles) noexcept
 {
     ChainSettings settings;
 
-    settings.gainKnob = pow(10, apvts.getRawParameterValue("GAIN")->load() / 20);
-    settings.slapLevel = apvts.getRawParameterValue("SLAP")->load();
-    settings.bypass = apvts.getRawParameterValue("BYPASS")->load();
-    settings.volumeSlap = pow(10, settings.slapLevel / 60);
-    settings.instrument = apvts.getRawParameterValue("INSTRUMENT")->load();
-    
+    settings.bypass = parameters.bypass->load() >= 0.5f;
+    settings.instrument = profiles.resolve((int) parameters.instrument->load());
+
+    settings.oversampling = juce::jlimit(0, 3, (int) parameters.oversampling->load());
+    settings.oversamplingMode = juce::jlimit(0, 1, (int) parameters.oversamplingMode->load());
+    auto eqMode = juce::jlimit(0, 2, (int) parameters.eqMode->load());
+    settings.linearPhaseEq = eqMode == 1;
+    settings.morphEq = eqMode == 2;
+    settings.lowCutSlope = juce::jlimit(0, CoefficientBank::numLowCutSlopes - 1, (int) parameters.lowCutSlope->load());
+
+    settings.ratio = parameters.ratio->load();
+    settings.attackMs = parameters.attack->load();
+    settings.releaseMs = parameters.release->load();
+    settings.kneeDecibels = parameters.knee->load();
+
+    settings.multiband = parameters.multiband->load() >= 0.5f;
+
+    for (size_t band = 0; band < (size_t) MultibandCompressor::numBands; ++band)
+        settings.bandSlapOffsets[band] = parameters.bandSlapOffsets[band]->load();
 
     return settings;
 }
@@ -448,14 +1024,51 @@ juce::AudioProcessorValueTreeState::ParameterLayout SlapsAudioProcessor::createP
     params.push_back(std::make_unique<juce::AudioParameterFloat>("SLAP", "Slap", -6.0f, 36.0f, 0.f));
     params.push_back(std::make_unique<juce::AudioParameterBool>("BYPASS", "Bypass", false));
 
-    juce::StringArray stringArray;
-    juce::String str;
-    stringArray.add("None");
-    stringArray.add("Kick");
-    stringArray.add("Snare");
-    stringArray.add("Hi Hat");
+    //the built in instruments come first so they keep their index, whatever gets added from the user's file,
+    //and there's always the same number of choices so automation never lands on a different instrument
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("INSTRUMENT", "Instrument", instrumentProfiles->getParameterChoices(), 0));
+
+    juce::StringArray oversamplingChoices;
+    oversamplingChoices.add("Off");
+    oversamplingChoices.add("2x");
+    oversamplingChoices.add("4x");
+    oversamplingChoices.add("8x");
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("OVERSAMPLING", "Oversampling", oversamplingChoices, 0));
+
+    juce::StringArray oversamplingModes;
+    oversamplingModes.add("Economy");
+    oversamplingModes.add("Linear Phase");
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("OVERSAMPLING_MODE", "Oversampling Mode", oversamplingModes, 0));
+
+    //the defaults are what the compressor was hard coded to before, with a hard knee. these and everything
+    //after them go on the end, so hosts that go by index still find the older parameters where they were
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("RATIO", "Ratio", juce::NormalisableRange<float>(1.0f, 20.0f, 0.1f, 0.5f), 10.0f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("ATTACK", "Attack", juce::NormalisableRange<float>(0.1f, 200.0f, 0.1f, 0.4f), 40.0f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("RELEASE", "Release", juce::NormalisableRange<float>(5.0f, 1000.0f, 1.0f, 0.4f), 200.0f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("KNEE", "Knee", juce::NormalisableRange<float>(0.0f, 24.0f, 0.1f), 0.0f));
+
+    //linear phase keeps the eq from smearing against the dry mics on a parallel bus, at the cost of latency.
+    //morph swaps the instrument's curve for CHARACTER's, which can be swept or automated without clicking
+    juce::StringArray eqModes = { "Minimum Phase", "Linear Phase", "Morph" };
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("EQ_MODE", "EQ Mode", eqModes, 0));
+
+    //multiband, each band's slap is SLAP plus its offset so turning it on starts out about where SLAP was
+    params.push_back(std::make_unique<juce::AudioParameterBool>("MULTIBAND", "Multiband", false));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("SLAP_LOW", "Low Slap", -24.0f, 24.0f, 0.f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("SLAP_MID", "Mid Slap", -24.0f, 24.0f, 0.f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("SLAP_HIGH", "High Slap", -24.0f, 24.0f, 0.f));
+
+    //parallel slap without a second bus, 100% is just the processed signal like it always was
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("MIX", "Mix", juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f), 100.0f));
+
+    //how steep the instrument's low cut is, each step is another butterworth section
+    juce::StringArray lowCutSlopes = { "12 dB/oct", "24 dB/oct", "36 dB/oct", "48 dB/oct" };
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("LOW_CUT_SLOPE", "Low Cut Slope", lowCutSlopes, 0));
 
-    params.push_back(std::make_unique<juce::AudioParameterChoice>("INSTRUMENT", "Instrument", stringArray, 0));
+    //only does anything in morph mode, 0 is the Kick's curve, 1 the Snare's and 2 the Hi Hat's
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("CHARACTER", "Character", juce::NormalisableRange<float>(0.0f, EqShape::maxCharacter, 0.01f), 1.0f));
 
 
     return { params.begin(), params.end() };
@@ -9,19 +9,64 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CoefficientBank.h"
+#include "FilterEngine.h"
+#include "MorphingEq.h"
+#include "LevelMeters.h"
+#include "SlapsCompressor.h"
+#include "MultibandCompressor.h"
+#include "LinearPhaseEq.h"
+#include "DryDelay.h"
+#include "ParameterState.h"
+#include "DspLoadMeter.h"
+#include "SpectrumAnalyser.h"
+#include "RealtimeChecks.h"
 
 struct ChainSettings
 {
-    float gainKnob{ 0 }, slapLevel{ 0 }, volumeSlap{ 0 }; bool bypass{ false }; int instrument{ 0 };
+    //GAIN, SLAP, MIX and CHARACTER aren't in here, processBlock reads them straight off the parameters
+    bool bypass{ false }; int instrument{ 0 };
 
+    //0 = off then 2x, 4x, 8x. the mode is 0 = economy (polyphase IIR) or 1 = linear phase (FIR)
+    int oversampling{ 0 }, oversamplingMode{ 0 };
+
+    //the eq as the usual minimum phase IIR cascade, or the same curve as a linear phase FIR. morph runs it
+    //as state variable filters instead, on the curve CHARACTER picks out between the Kick, Snare and Hi Hat
+    bool linearPhaseEq{ false }, morphEq{ false };
+
+    //0 = 12 dB/oct up to 3 = 48 dB/oct
+    int lowCutSlope{ 0 };
+
+    //the compressor, threshold still comes from the slap knob
+    float ratio{ 10 }, attackMs{ 40 }, releaseMs{ 200 }, kneeDecibels{ 0 };
+
+    //multiband splits the compressor into low, mid and high at the instrument's crossovers. each band's
+    //slap is the SLAP knob plus its own offset, in the same order as MultibandCompressor::Band
+    bool multiband{ false };
+    std::array<float, MultibandCompressor::numBands> bandSlapOffsets{};
+};
+
+//the raw values ChainSettings gets made from, looked up once so the audio thread can rebuild it without searching by ID
+struct ChainParameters
+{
+    explicit ChainParameters(juce::AudioProcessorValueTreeState& apvts);
+
+    std::atomic<float>* bypass; std::atomic<float>* instrument;
+    std::atomic<float>* oversampling; std::atomic<float>* oversamplingMode;
+    std::atomic<float>* eqMode; std::atomic<float>* lowCutSlope;
+    std::atomic<float>* ratio; std::atomic<float>* attack; std::atomic<float>* release; std::atomic<float>* knee;
+    std::atomic<float>* multiband;
+    std::array<std::atomic<float>*, MultibandCompressor::numBands> bandSlapOffsets;
 };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+//only loads and a few clamps, so it's fine to call on the audio thread
+ChainSettings getChainSettings(const ChainParameters& parameters, const InstrumentProfiles& profiles) noexcept;
 
 //==============================================================================
 /**
 */
-class SlapsAudioProcessor  : public juce::AudioProcessor
+class SlapsAudioProcessor  : public juce::AudioProcessor,
+    private juce::AudioProcessorValueTreeState::Listener, private juce::Timer
 {
 public:
     //==============================================================================
@@ -37,6 +82,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    //the whole chain runs natively in double when the host wants it, no converting around us
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -61,22 +110,21 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    double rawVolume = 0;
-    float slapLevel = 0;
-    int instrument = 1;
-    double volumeSlap = 1;
+    //every channel's levels, for the editor to read whenever it wants
+    LevelMeters meters;
+
+    //processBlock does everything in one pass over the buffer, a tile at a time. turn this off to go
+    //back to running each stage over the whole buffer, the output is the same either way
+    std::atomic<bool> useFusedKernel{ true };
 
-    float peakOneFreq;
-    float peakTwoFreq;
-    float peakThreeFreq;
-    float peakOneQ;
-    float peakTwoQ;
-    float peakThreeQ;
-    float cutFreq;
+    //how much of each block's time processBlock is using up, for the editor
+    DspLoadMeter dspLoad;
 
-    bool pluginBypassed{ false };
+    //input and output spectra for the editor, does nothing unless one's showing it
+    SpectrumAnalyser analyser;
 
-    float peakLevel;
+    //the built in instruments plus any from the user's file, made before apvts since INSTRUMENT gets its choices from it
+    juce::SharedResourcePointer<InstrumentProfiles> instrumentProfiles;
 
     //what you gotta do for the slider parameters to save
     juce::AudioProcessorValueTreeState apvts;
@@ -87,25 +135,179 @@ private:
 
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
-    juce::dsp::Compressor<float> compressor;
+    //parameter changes can come in on any thread, including the audio thread while automation's playing,
+    //so all they do is flag it. processSamples rebuilds chainSettings from chainParameters on its next block
+    //and the timer updates the latency on the message thread
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void timerCallback() override;
+
+    ChainParameters chainParameters{ apvts };
+    std::atomic<bool> chainSettingsChanged{ false }, latencyChanged{ false };
+
+    //in ParameterState's order, looked up once so saving and loading never search by ID
+    std::array<juce::RangedAudioParameter*, ParameterState::numParameters> stateParameters{};
+
+    //only made if SLAPS_DSP_LOAD_LOG says where to write
+    std::unique_ptr<DspLoadLog> dspLoadLog;
+
+    //only touched by the audio thread (or prepareToPlay, when it isn't running)
+    ChainSettings chainSettings;
+    void applyChainSettings();
 
-    using Filter = juce::dsp::IIR::Filter<float>;
+    //filled in as each block gets processed, then pushed to meters at the end
+    LevelMeters::BlockLevels blockLevels;
+    static_assert(LevelMeters::maxNumChannels == (int) FilterEngine<float>::maxNumChannels, "the meters need a slot for every channel we can process");
 
-    using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+    //GAIN and SLAP get ramped over this long. while they're moving each block gets split into sub blocks
+    //this big, and the threshold and eq are updated once per sub block
+    static constexpr double smoothingSeconds = 0.02;
+    static constexpr int smoothingSubBlockSize = 32;
 
-    using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, Filter, Filter, CutFilter>;
+    //samplesPerBlock from prepareToPlay, the biggest chunk any of the stages get given
+    int preparedBlockSize = 0;
 
-    MonoChain leftChain, rightChain;
+    std::atomic<float>* gainParameter = nullptr;
+    std::atomic<float>* slapParameter = nullptr;
+    std::atomic<float>* mixParameter = nullptr;
+    std::atomic<float>* characterParameter = nullptr;
 
-    enum ChainPositions
+    //where CHARACTER was last block and its curve, the morphing eq glides on from there by itself
+    float character = 1.0f;
+    EqShape characterShape = EqShape::forCharacter(1.0f);
+
+    //both in dB
+    juce::SmoothedValue<float> smoothedGain, smoothedSlap;
+
+    //MIX as 0 to 1, gets ramped the same way so the crossfade never clicks
+    juce::SmoothedValue<float> smoothedMix;
+
+    //the input held back by the same latency as the wet signal, for the MIX knob. only the one for the
+    //precision we're running in gets prepared
+    std::tuple<DryDelay<float>, DryDelay<double>> dryDelays;
+
+    template <typename SampleType>
+    DryDelay<SampleType>& getDryDelay() noexcept { return std::get<DryDelay<SampleType>>(dryDelays); }
+
+    template <typename Function>
+    void withActiveDryDelay(Function&& function);
+
+    void applySlap(float slapLevel) noexcept;
+    float getOutputGain(float gainDecibels, float slapLevel) const noexcept;
+
+    //once the input's been below -120 dBFS for longer than the tail, the whole chain gets skipped
+    static constexpr float silenceThreshold = 1.0e-6f;
+    int tailSamples = 0, silentSamples = 0;
+    bool idle = false;
+
+    //the same tail in seconds, for the host
+    std::atomic<double> tailSeconds{ 0.0 };
+
+    //eqDecaySamples is how long the eq rings for at the rate the path runs at
+    void updateTail(int eqDecaySamples) noexcept;
+
+    template <typename SampleType>
+    void processIdle(juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    template <typename SampleType>
+    static bool isSilent(const juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    //a gain that goes in a straight line across a sub block, sample i gets at(i)
+    struct GainRamp
     {
-        LowCut,
-        PeakOne,
-        PeakTwo,
-        PeakThree,
-        HighCut
+        float start, step;
+
+        float at(int i) const noexcept { return start + step * (float) i; }
+
+        static GainRamp between(float startGain, float endGain, int numSamples) noexcept
+        {
+            return { startGain, numSamples > 0 ? (endGain - startGain) / (float) numSamples : 0.0f };
+        }
     };
 
+    //both processBlocks end up here
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    //each stage over the whole buffer in turn, which is the only way to oversample (and to run in double)
+    template <typename SampleType>
+    void processStaged(juce::AudioBuffer<SampleType>& buffer, GainRamp inputGain, GainRamp outputGain) noexcept;
+
+    //input gain, metering, compressor, eq and output gain all done per tile while it's still in cache.
+    //only used without oversampling, the oversampled path goes through the stages one by one
+    static constexpr int fusedTileSize = 64;
+    void processFused(juce::AudioBuffer<float>& buffer, GainRamp inputGain, GainRamp outputGain) noexcept;
+
+    //the compressor and eq, plus all the coefficients they could need at the rate they run at
+    struct ProcessingPath
+    {
+        SlapsCompressor compressor;
+
+        //takes over from compressor in multiband mode, with the same settings
+        MultibandCompressor multiband;
+
+        //the whole eq, every channel at once. only the one for the precision we're running in gets prepared
+        std::tuple<FilterEngine<float>, FilterEngine<double>> filterEngines;
+
+        template <typename SampleType>
+        FilterEngine<SampleType>& getFilterEngine() noexcept { return std::get<FilterEngine<SampleType>>(filterEngines); }
+
+        //takes over from the filter engine in morph mode, same deal with the precisions
+        std::tuple<MorphingEq<float>, MorphingEq<double>> morphingEqs;
+
+        template <typename SampleType>
+        MorphingEq<SampleType>& getMorphingEq() noexcept { return std::get<MorphingEq<SampleType>>(morphingEqs); }
+
+        //the longest the morphing eq could ring for at each low cut slope, worked out in prepareToPlay
+        std::array<int, CoefficientBank::numLowCutSlopes> morphDecaySamples{};
+
+        //shared with every other instance running at this rate, and never changed once it's built
+        std::shared_ptr<const CoefficientBank> coefficientBank;
+    };
+
+    //one path per oversampling factor (1x, 2x, 4x, 8x), each prepared at its own rate in prepareToPlay
+    //so switching factors never has to allocate or design anything
+    static constexpr int numOversamplingFactors = 4;
+    std::array<ProcessingPath, numOversamplingFactors> paths;
+    int activeOversampling = 0, activeOversamplingMode = 0;
+
+    //[mode][factor - 1], all made in prepareToPlay for whichever precision we're running in
+    template <typename SampleType>
+    using OversamplerSet = std::array<std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, numOversamplingFactors - 1>, 2>;
+
+    std::tuple<OversamplerSet<float>, OversamplerSet<double>> oversamplers;
+
+    template <typename SampleType>
+    juce::dsp::Oversampling<SampleType>* getOversampler(const ChainSettings& settings) const noexcept;
+
+    template <typename SampleType>
+    void prepareOversamplers(const juce::dsp::ProcessSpec& spec);
+
+    //the filter engine and oversampler for whichever precision the host has asked for
+    template <typename Function>
+    void withActiveFilterEngine(ProcessingPath& path, Function&& function);
+
+    template <typename Function>
+    void withActiveMorphingEq(ProcessingPath& path, Function&& function);
+
+    void resetActiveOversampler() noexcept;
+    int getOversamplingLatency(const ChainSettings& settings) const noexcept;
+
+    //the oversampling plus the linear phase eq if it's on
+    int getProcessingLatency(const ChainSettings& settings) const noexcept;
+
+    //the most that could be, over every oversampling setting with the linear phase eq on
+    int getMaxProcessingLatency() const noexcept;
+    void updateLatency(const ChainSettings& settings);
+
+    //runs at the host rate after the oversampling, and gets its kernels designed off the audio thread.
+    //it follows where slap is headed rather than every step of the ramp, each new kernel gets crossfaded in
+    LinearPhaseEq linearPhaseEq;
+    bool linearPhaseActive = false, multibandActive = false, morphActive = false;
+    int requestedKernel = -1;
+
+    int getLinearPhaseKernelId() const noexcept;
+    EqCoefficients getLinearPhaseTarget() const noexcept;
+    void requestLinearPhaseKernel() noexcept;
 
 
     //==============================================================================
@@ -0,0 +1,369 @@
+/*
+  ==============================================================================
+
+    RealtimeChecks.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeChecks.h"
+
+#if SLAPS_RT_CHECKS
+
+#include <new>
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #define SLAPS_WRAP_LIBC 1
+#else
+ #define SLAPS_WRAP_LIBC 0
+#endif
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+ #define SLAPS_PATCH_IMPORTS 1
+#else
+ #define SLAPS_PATCH_IMPORTS 0
+#endif
+
+#if JUCE_LINUX && JUCE_64BIT
+//ours only, so the host and everything else it's loaded carry on with the real ones. the visibility attribute
+//gets ignored on anything <new> and <stdlib.h> already declared, so this tells the assembler directly. the mac
+//doesn't need it, calls inside a bundle bind to the bundle's own definitions there anyway
+__asm__(".hidden malloc\n.hidden calloc\n.hidden realloc\n.hidden free\n.hidden pthread_mutex_lock\n"
+        ".hidden _Znwm\n.hidden _Znam\n.hidden _ZnwmRKSt9nothrow_t\n.hidden _ZnamRKSt9nothrow_t\n"
+        ".hidden _ZnwmSt11align_val_t\n.hidden _ZnamSt11align_val_t\n"
+        ".hidden _ZdlPv\n.hidden _ZdaPv\n.hidden _ZdlPvm\n.hidden _ZdaPvm\n"
+        ".hidden _ZdlPvRKSt9nothrow_t\n.hidden _ZdaPvRKSt9nothrow_t\n"
+        ".hidden _ZdlPvSt11align_val_t\n.hidden _ZdaPvSt11align_val_t\n"
+        ".hidden _ZdlPvmSt11align_val_t\n.hidden _ZdaPvmSt11align_val_t\n");
+#endif
+
+namespace
+{
+    thread_local int audioThreadDepth = 0;
+    thread_local bool reporting = false;
+    std::atomic<int> numViolations{ 0 };
+
+    //after this many only the count goes up, so one bad block doesn't bury everything else in backtraces
+    constexpr int maxReports = 32;
+
+    void report(const char* what)
+    {
+        if (audioThreadDepth == 0 || reporting)
+            return;
+
+        //nothing in here gets checked, the backtrace and the logging both allocate
+        reporting = true;
+
+        if (++numViolations <= maxReports)
+            juce::Logger::writeToLog(juce::String("Slaps: ") + what + " on the audio thread\n" + juce::SystemStats::getStackBacktrace());
+
+        reporting = false;
+    }
+
+   #if SLAPS_WRAP_LIBC
+    //whatever the process would have used if we weren't here, looked up the first time anything allocates
+    struct LibcFunctions
+    {
+        void* (*malloc)(size_t);
+        void* (*calloc)(size_t, size_t);
+        void* (*realloc)(void*, size_t);
+        void (*free)(void*);
+        int (*mutexLock)(pthread_mutex_t*);
+    };
+
+    template <typename Function>
+    Function find(const char* name)
+    {
+        auto* function = reinterpret_cast<Function>(dlsym(RTLD_DEFAULT, name));
+        jassert(function != nullptr);
+        return function;
+    }
+
+    const LibcFunctions& getLibc()
+    {
+        static const LibcFunctions libc
+        {
+            find<void* (*)(size_t)>("malloc"),
+            find<void* (*)(size_t, size_t)>("calloc"),
+            find<void* (*)(void*, size_t)>("realloc"),
+            find<void (*)(void*)>("free"),
+            find<int (*)(pthread_mutex_t*)>("pthread_mutex_lock")
+        };
+
+        return libc;
+    }
+
+    void* allocate(size_t size)   { return getLibc().malloc(size); }
+    void deallocate(void* p)      { getLibc().free(p); }
+   #elif SLAPS_PATCH_IMPORTS
+    //the real ones, taken out of our import table as it gets patched. until then the table still points at
+    //them, so plain malloc and free are fine
+    struct ImportedFunctions
+    {
+        void* (__cdecl* malloc)(size_t) = nullptr;
+        void* (__cdecl* calloc)(size_t, size_t) = nullptr;
+        void* (__cdecl* realloc)(void*, size_t) = nullptr;
+        void (__cdecl* free)(void*) = nullptr;
+        void (WINAPI* enterCriticalSection)(LPCRITICAL_SECTION) = nullptr;
+        void (WINAPI* acquireSRWLockExclusive)(PSRWLOCK) = nullptr;
+        int (__cdecl* mutexLock)(void*) = nullptr;
+    };
+
+    ImportedFunctions imported;
+
+    void* allocate(size_t size)   { return imported.malloc != nullptr ? imported.malloc(size) : std::malloc(size); }
+    void deallocate(void* p)      { imported.free != nullptr ? imported.free(p) : std::free(p); }
+   #else
+    void* allocate(size_t size)   { return std::malloc(size); }
+    void deallocate(void* p)      { std::free(p); }
+   #endif
+
+    void* allocateAligned(size_t size, size_t alignment)
+    {
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size, alignment);
+       #else
+        void* p = nullptr;
+        return posix_memalign(&p, juce::jmax(alignment, sizeof(void*)), size) == 0 ? p : nullptr;
+       #endif
+    }
+
+    void deallocateAligned(void* p)
+    {
+       #if JUCE_WINDOWS
+        _aligned_free(p);
+       #else
+        deallocate(p);
+       #endif
+    }
+}
+
+namespace RealtimeChecks
+{
+    ScopedAudioThread::ScopedAudioThread() noexcept  { ++audioThreadDepth; }
+    ScopedAudioThread::~ScopedAudioThread()          { --audioThreadDepth; }
+
+    int getNumViolations() noexcept { return numViolations.load(); }
+}
+
+//==============================================================================
+void* operator new(std::size_t size)
+{
+    report("operator new");
+
+    if (auto* p = allocate(size != 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)                                   { return operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept     { report("operator new"); return allocate(size != 0 ? size : 1); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept   { report("operator new"); return allocate(size != 0 ? size : 1); }
+
+void operator delete(void* p) noexcept
+{
+    if (p != nullptr)
+        report("operator delete");
+
+    deallocate(p);
+}
+
+void operator delete[](void* p) noexcept                                 { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept                      { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept                    { operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept            { operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept          { operator delete(p); }
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    report("operator new");
+
+    if (auto* p = allocateAligned(size != 0 ? size : 1, (size_t) alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)       { return operator new(size, alignment); }
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    if (p != nullptr)
+        report("operator delete");
+
+    deallocateAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept                 { operator delete(p, alignment); }
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept      { operator delete(p, alignment); }
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept    { operator delete(p, alignment); }
+
+//==============================================================================
+#if SLAPS_WRAP_LIBC
+//juce's HeapBlock (so AudioBuffer, Array and friends) goes straight to malloc, and CriticalSection and
+//std::mutex both end up in pthread_mutex_lock
+extern "C"
+{
+    void* malloc(size_t size) noexcept
+    {
+        report("malloc");
+        return getLibc().malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        report("calloc");
+        return getLibc().calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size) noexcept
+    {
+        report("realloc");
+        return getLibc().realloc(p, size);
+    }
+
+    void free(void* p) noexcept
+    {
+        if (p != nullptr)
+            report("free");
+
+        getLibc().free(p);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        report("pthread_mutex_lock");
+        return getLibc().mutexLock(mutex);
+    }
+}
+#endif
+
+//==============================================================================
+#if SLAPS_PATCH_IMPORTS
+//windows has nothing like symbol interposition, so instead our own module's import table gets pointed at
+//these as soon as it loads. that only covers calls from our code (and juce, which is compiled into it),
+//so the host and everything else it's loaded carry on with the real ones. it needs the DLL runtime, with
+//a static one malloc and free are inside the module and never go through the table. HeapBlock (so
+//AudioBuffer, Array and friends) goes to malloc, CriticalSection to EnterCriticalSection and std::mutex
+//to _Mtx_lock in the C++ runtime, which takes an SRW lock
+namespace
+{
+    void* __cdecl checkedMalloc(size_t size)                { report("malloc"); return imported.malloc(size); }
+    void* __cdecl checkedCalloc(size_t count, size_t size)  { report("calloc"); return imported.calloc(count, size); }
+    void* __cdecl checkedRealloc(void* p, size_t size)      { report("realloc"); return imported.realloc(p, size); }
+
+    void __cdecl checkedFree(void* p)
+    {
+        if (p != nullptr)
+            report("free");
+
+        imported.free(p);
+    }
+
+    void WINAPI checkedEnterCriticalSection(LPCRITICAL_SECTION section)
+    {
+        report("EnterCriticalSection");
+        imported.enterCriticalSection(section);
+    }
+
+    void WINAPI checkedAcquireSRWLockExclusive(PSRWLOCK lock)
+    {
+        report("AcquireSRWLockExclusive");
+        imported.acquireSRWLockExclusive(lock);
+    }
+
+    int __cdecl checkedMutexLock(void* mutex)
+    {
+        report("std::mutex lock");
+        return imported.mutexLock(mutex);
+    }
+
+    struct ImportPatch
+    {
+        const char* name;
+        void* replacement;
+        void** original;
+    };
+
+    //every by-name import of ours called one of these gets pointed at its replacement, whichever dll it's from
+    void patchImports(HMODULE module, std::initializer_list<ImportPatch> patches)
+    {
+        auto* base = reinterpret_cast<BYTE*>(module);
+        auto* headers = reinterpret_cast<IMAGE_NT_HEADERS*>(base + reinterpret_cast<IMAGE_DOS_HEADER*>(base)->e_lfanew);
+        auto& directory = headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+
+        if (directory.VirtualAddress == 0)
+            return;
+
+        for (auto* descriptor = reinterpret_cast<IMAGE_IMPORT_DESCRIPTOR*>(base + directory.VirtualAddress); descriptor->Name != 0; ++descriptor)
+        {
+            if (descriptor->OriginalFirstThunk == 0)
+                continue;
+
+            auto* names = reinterpret_cast<IMAGE_THUNK_DATA*>(base + descriptor->OriginalFirstThunk);
+            auto* addresses = reinterpret_cast<IMAGE_THUNK_DATA*>(base + descriptor->FirstThunk);
+
+            for (; names->u1.AddressOfData != 0; ++names, ++addresses)
+            {
+                if (IMAGE_SNAP_BY_ORDINAL(names->u1.Ordinal))
+                    continue;
+
+                auto* name = reinterpret_cast<const char*>(reinterpret_cast<IMAGE_IMPORT_BY_NAME*>(base + names->u1.AddressOfData)->Name);
+
+                for (auto& patch : patches)
+                {
+                    if (std::strcmp(name, patch.name) != 0)
+                        continue;
+
+                    auto* slot = &addresses->u1.Function;
+                    DWORD oldProtection;
+
+                    if (! VirtualProtect(slot, sizeof(*slot), PAGE_READWRITE, &oldProtection))
+                        continue;
+
+                    if (*patch.original == nullptr)
+                        *patch.original = reinterpret_cast<void*>(*slot);
+
+                    *slot = reinterpret_cast<ULONG_PTR>(patch.replacement);
+                    VirtualProtect(slot, sizeof(*slot), oldProtection, &oldProtection);
+                }
+            }
+        }
+    }
+
+    //done while the module's loading, before anything of ours can be on an audio thread
+    struct ImportPatcher
+    {
+        ImportPatcher()
+        {
+            HMODULE module = nullptr;
+
+            if (! GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                     reinterpret_cast<LPCWSTR>(&report), &module))
+                return;
+
+            patchImports(module, { { "malloc",  reinterpret_cast<void*>(&checkedMalloc),  reinterpret_cast<void**>(&imported.malloc) },
+                                   { "calloc",  reinterpret_cast<void*>(&checkedCalloc),  reinterpret_cast<void**>(&imported.calloc) },
+                                   { "realloc", reinterpret_cast<void*>(&checkedRealloc), reinterpret_cast<void**>(&imported.realloc) },
+                                   { "free",    reinterpret_cast<void*>(&checkedFree),    reinterpret_cast<void**>(&imported.free) },
+                                   { "EnterCriticalSection",    reinterpret_cast<void*>(&checkedEnterCriticalSection),    reinterpret_cast<void**>(&imported.enterCriticalSection) },
+                                   { "AcquireSRWLockExclusive", reinterpret_cast<void*>(&checkedAcquireSRWLockExclusive), reinterpret_cast<void**>(&imported.acquireSRWLockExclusive) },
+                                   { "_Mtx_lock",               reinterpret_cast<void*>(&checkedMutexLock),               reinterpret_cast<void**>(&imported.mutexLock) } });
+        }
+    };
+
+    const ImportPatcher importPatcher;
+}
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    RealtimeChecks.h
+
+    Build with SLAPS_RT_CHECKS=1 (the Debug configurations do) and anything
+    in Slaps that allocates, frees or locks a mutex while a
+    ScopedAudioThread is alive gets logged with a stack trace. It works by
+    swapping in our own operator new/delete everywhere, plus malloc, calloc,
+    realloc, free and pthread_mutex_lock on macOS and Linux, all only
+    visible inside our own binary so the host is left alone. On Windows
+    the same allocation functions plus EnterCriticalSection,
+    AcquireSRWLockExclusive and _Mtx_lock (std::mutex) get caught by
+    patching our own module's import table when it loads, which needs the
+    DLL runtime the Debug configurations use. With it off all of this
+    compiles away to nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef SLAPS_RT_CHECKS
+ #define SLAPS_RT_CHECKS 0
+#endif
+
+namespace RealtimeChecks
+{
+   #if SLAPS_RT_CHECKS
+    //everything on this thread is audio thread code until it goes out of scope
+    class ScopedAudioThread
+    {
+    public:
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread();
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioThread)
+    };
+
+    //how many times it's been caught so far, in any instance
+    int getNumViolations() noexcept;
+   #else
+    class ScopedAudioThread
+    {
+    public:
+        ScopedAudioThread() noexcept {}
+    };
+
+    inline int getNumViolations() noexcept { return 0; }
+   #endif
+}
@@ -0,0 +1,338 @@
+/*
+  ==============================================================================
+
+    SlapsCompressor.cpp
+
+  ==============================================================================
+*/
+
+#include "SlapsCompressor.h"
+
+namespace
+{
+    //6.02 dB to a doubling
+    constexpr float decibelsPerOctave = 6.0205999f;
+
+    //four lanes at a time with SSE or NEON, or plain floats on anything else. the compiler won't vectorise
+    //the log2/exp2 bit twiddling on its own, so this spells it out
+    struct FourFloats
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        __m128 v;
+
+        static FourFloats load(const float* p) noexcept                          { return { _mm_loadu_ps(p) }; }
+        void store(float* p) const noexcept                                      { _mm_storeu_ps(p, v); }
+        static FourFloats expand(float x) noexcept                               { return { _mm_set1_ps(x) }; }
+
+        friend FourFloats operator+ (FourFloats a, FourFloats b) noexcept        { return { _mm_add_ps(a.v, b.v) }; }
+        friend FourFloats operator- (FourFloats a, FourFloats b) noexcept        { return { _mm_sub_ps(a.v, b.v) }; }
+        friend FourFloats operator* (FourFloats a, FourFloats b) noexcept        { return { _mm_mul_ps(a.v, b.v) }; }
+
+        static FourFloats min(FourFloats a, FourFloats b) noexcept               { return { _mm_min_ps(a.v, b.v) }; }
+        static FourFloats max(FourFloats a, FourFloats b) noexcept               { return { _mm_max_ps(a.v, b.v) }; }
+        static FourFloats abs(FourFloats a) noexcept                             { return { _mm_and_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))) }; }
+
+        //a > b ? ifTrue : ifFalse, lane by lane
+        static FourFloats selectGreater(FourFloats a, FourFloats b, FourFloats ifTrue, FourFloats ifFalse) noexcept
+        {
+            auto mask = _mm_cmpgt_ps(a.v, b.v);
+            return { _mm_or_ps(_mm_and_ps(mask, ifTrue.v), _mm_andnot_ps(mask, ifFalse.v)) };
+        }
+
+        //the unbiased exponent as a float, and the mantissa moved into [1, 2)
+        static FourFloats exponent(FourFloats x) noexcept
+        {
+            return { _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(x.v), 23), _mm_set1_epi32(127))) };
+        }
+
+        static FourFloats mantissa(FourFloats x) noexcept
+        {
+            auto bits = _mm_and_si128(_mm_castps_si128(x.v), _mm_set1_epi32(0x007fffff));
+            return { _mm_castsi128_ps(_mm_or_si128(bits, _mm_set1_epi32(0x3f800000))) };
+        }
+
+        static FourFloats truncate(FourFloats x) noexcept                        { return { _mm_cvtepi32_ps(_mm_cvttps_epi32(x.v)) }; }
+
+        //x * 2^whole, for whole numbers that keep the result a normal float
+        static FourFloats scaleByPowerOfTwo(FourFloats x, FourFloats whole) noexcept
+        {
+            return { _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(x.v), _mm_slli_epi32(_mm_cvttps_epi32(whole.v), 23))) };
+        }
+       #elif JUCE_USE_ARM_NEON
+        float32x4_t v;
+
+        static FourFloats load(const float* p) noexcept                          { return { vld1q_f32(p) }; }
+        void store(float* p) const noexcept                                      { vst1q_f32(p, v); }
+        static FourFloats expand(float x) noexcept                               { return { vdupq_n_f32(x) }; }
+
+        friend FourFloats operator+ (FourFloats a, FourFloats b) noexcept        { return { vaddq_f32(a.v, b.v) }; }
+        friend FourFloats operator- (FourFloats a, FourFloats b) noexcept        { return { vsubq_f32(a.v, b.v) }; }
+        friend FourFloats operator* (FourFloats a, FourFloats b) noexcept        { return { vmulq_f32(a.v, b.v) }; }
+
+        static FourFloats min(FourFloats a, FourFloats b) noexcept               { return { vminq_f32(a.v, b.v) }; }
+        static FourFloats max(FourFloats a, FourFloats b) noexcept               { return { vmaxq_f32(a.v, b.v) }; }
+        static FourFloats abs(FourFloats a) noexcept                             { return { vabsq_f32(a.v) }; }
+
+        static FourFloats selectGreater(FourFloats a, FourFloats b, FourFloats ifTrue, FourFloats ifFalse) noexcept
+        {
+            return { vbslq_f32(vcgtq_f32(a.v, b.v), ifTrue.v, ifFalse.v) };
+        }
+
+        static FourFloats exponent(FourFloats x) noexcept
+        {
+            auto biased = vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_f32(x.v), 23));
+            return { vcvtq_f32_s32(vsubq_s32(biased, vdupq_n_s32(127))) };
+        }
+
+        static FourFloats mantissa(FourFloats x) noexcept
+        {
+            auto bits = vandq_u32(vreinterpretq_u32_f32(x.v), vdupq_n_u32(0x007fffff));
+            return { vreinterpretq_f32_u32(vorrq_u32(bits, vdupq_n_u32(0x3f800000))) };
+        }
+
+        static FourFloats truncate(FourFloats x) noexcept                        { return { vcvtq_f32_s32(vcvtq_s32_f32(x.v)) }; }
+
+        static FourFloats scaleByPowerOfTwo(FourFloats x, FourFloats whole) noexcept
+        {
+            auto shifted = vshlq_n_s32(vcvtq_s32_f32(whole.v), 23);
+            return { vreinterpretq_f32_s32(vaddq_s32(vreinterpretq_s32_f32(x.v), shifted)) };
+        }
+       #else
+        std::array<float, 4> v;
+
+        template <typename Function>
+        static FourFloats forEach(Function&& f) noexcept
+        {
+            FourFloats result;
+
+            for (size_t i = 0; i < 4; ++i)
+                result.v[i] = f(i);
+
+            return result;
+        }
+
+        static FourFloats load(const float* p) noexcept                          { return forEach([p] (size_t i) { return p[i]; }); }
+        void store(float* p) const noexcept                                      { std::copy(v.begin(), v.end(), p); }
+        static FourFloats expand(float x) noexcept                               { return forEach([x] (size_t) { return x; }); }
+
+        friend FourFloats operator+ (FourFloats a, FourFloats b) noexcept        { return forEach([&] (size_t i) { return a.v[i] + b.v[i]; }); }
+        friend FourFloats operator- (FourFloats a, FourFloats b) noexcept        { return forEach([&] (size_t i) { return a.v[i] - b.v[i]; }); }
+        friend FourFloats operator* (FourFloats a, FourFloats b) noexcept        { return forEach([&] (size_t i) { return a.v[i] * b.v[i]; }); }
+
+        static FourFloats min(FourFloats a, FourFloats b) noexcept               { return forEach([&] (size_t i) { return juce::jmin(a.v[i], b.v[i]); }); }
+        static FourFloats max(FourFloats a, FourFloats b) noexcept               { return forEach([&] (size_t i) { return juce::jmax(a.v[i], b.v[i]); }); }
+        static FourFloats abs(FourFloats a) noexcept                             { return forEach([&] (size_t i) { return std::abs(a.v[i]); }); }
+
+        static FourFloats selectGreater(FourFloats a, FourFloats b, FourFloats ifTrue, FourFloats ifFalse) noexcept
+        {
+            return forEach([&] (size_t i) { return a.v[i] > b.v[i] ? ifTrue.v[i] : ifFalse.v[i]; });
+        }
+
+        static FourFloats exponent(FourFloats x) noexcept
+        {
+            return forEach([&] (size_t i) { return (float) std::ilogb(x.v[i]); });
+        }
+
+        static FourFloats mantissa(FourFloats x) noexcept
+        {
+            return forEach([&] (size_t i) { return x.v[i] > 0.0f ? std::scalbn(x.v[i], -std::ilogb(x.v[i])) : 1.0f; });
+        }
+
+        static FourFloats truncate(FourFloats x) noexcept                        { return forEach([&] (size_t i) { return (float) (int32_t) x.v[i]; }); }
+
+        static FourFloats scaleByPowerOfTwo(FourFloats x, FourFloats whole) noexcept
+        {
+            return forEach([&] (size_t i) { return std::ldexp(x.v[i], (int) whole.v[i]); });
+        }
+       #endif
+    };
+
+    //the same polynomials as SlapsCompressor::fastLog2 and fastExp2, four at a time
+    FourFloats fastLog2Lanes(FourFloats x) noexcept
+    {
+        auto t = FourFloats::mantissa(x) - FourFloats::expand(1.0f);
+
+        auto poly = FourFloats::expand(-0.0252855056f);
+        poly = poly * t + FourFloats::expand(0.1201002580f);
+        poly = poly * t - FourFloats::expand(0.2759689553f);
+        poly = poly * t + FourFloats::expand(0.4565404101f);
+        poly = poly * t - FourFloats::expand(0.7179134799f);
+        poly = poly * t + FourFloats::expand(1.4425272727f);
+
+        return FourFloats::exponent(x) + poly * t;
+    }
+
+    FourFloats fastExp2Lanes(FourFloats x) noexcept
+    {
+        x = FourFloats::min(FourFloats::expand(126.0f), FourFloats::max(FourFloats::expand(-126.0f), x));
+
+        auto whole = FourFloats::truncate(x);
+        whole = whole - FourFloats::selectGreater(whole, x, FourFloats::expand(1.0f), FourFloats::expand(0.0f));
+        auto t = x - whole;
+
+        auto poly = FourFloats::expand(0.0018955585f);
+        poly = poly * t + FourFloats::expand(0.0089505589f);
+        poly = poly * t + FourFloats::expand(0.0558533533f);
+        poly = poly * t + FourFloats::expand(0.2401475577f);
+        poly = poly * t + FourFloats::expand(0.6931529716f);
+        poly = poly * t + FourFloats::expand(1.0f);
+
+        return FourFloats::scaleByPowerOfTwo(poly, whole);
+    }
+}
+
+void SlapsCompressor::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels <= maxNumChannels);
+
+    sampleRate = spec.sampleRate;
+    updateBallistics();
+    reset();
+}
+
+void SlapsCompressor::reset() noexcept
+{
+    envelopes.fill(0.0f);
+}
+
+void SlapsCompressor::setThreshold(float newThresholdDecibels) noexcept
+{
+    //juce's compressor bottoms out at -200 dB too
+    thresholdDecibels = juce::jmax(-200.0f, newThresholdDecibels);
+    thresholdLog2 = thresholdDecibels / decibelsPerOctave;
+    laneThresholdsLog2.fill(thresholdLog2);
+}
+
+void SlapsCompressor::setLaneThreshold(size_t lane, float newThresholdDecibels) noexcept
+{
+    jassert(lane < numLanes);
+    laneThresholdsLog2[lane] = juce::jmax(-200.0f, newThresholdDecibels) / decibelsPerOctave;
+}
+
+void SlapsCompressor::setRatio(float newRatio) noexcept
+{
+    jassert(newRatio >= 1.0f);
+
+    ratio = juce::jmax(1.0f, newRatio);
+    slope = 1.0f / ratio - 1.0f;
+}
+
+void SlapsCompressor::setAttack(float newAttackMs) noexcept
+{
+    attackMs = newAttackMs;
+    updateBallistics();
+}
+
+void SlapsCompressor::setRelease(float newReleaseMs) noexcept
+{
+    releaseMs = newReleaseMs;
+    updateBallistics();
+}
+
+void SlapsCompressor::setKnee(float newKneeDecibels) noexcept
+{
+    kneeDecibels = juce::jmax(0.0f, newKneeDecibels);
+    updateKnee();
+}
+
+int SlapsCompressor::getReleaseSamples(float decayGain) const noexcept
+{
+    if (releaseCoefficient <= 0.0f)
+        return 0;
+
+    return (int) std::ceil(std::log(decayGain) / std::log(releaseCoefficient));
+}
+
+//same time constants as juce::dsp::BallisticsFilter, so the envelope follows the old one exactly
+void SlapsCompressor::updateBallistics() noexcept
+{
+    auto expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+
+    auto timeToCoefficient = [expFactor] (float timeMs)
+    {
+        return timeMs < 1.0e-3f ? 0.0f : (float) std::exp(expFactor / timeMs);
+    };
+
+    attackCoefficient = timeToCoefficient(attackMs);
+    releaseCoefficient = timeToCoefficient(releaseMs);
+}
+
+void SlapsCompressor::updateKnee() noexcept
+{
+    kneeLog2 = kneeDecibels / decibelsPerOctave;
+    halfKneeLog2 = kneeLog2 * 0.5f;
+
+    //with no knee this is 0 and the clamped term in getGain vanishes, leaving a hard knee
+    kneeScale = kneeLog2 > 0.0f ? 0.5f / kneeLog2 : 0.0f;
+}
+
+template <typename SampleType>
+void SlapsCompressor::process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    auto numChannels = block.getNumChannels();
+    auto numSamples = block.getNumSamples();
+
+    jassert(numChannels <= maxNumChannels);
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* channelData = block.getChannelPointer(ch);
+        auto envelope = envelopes[ch];
+
+        for (size_t i = 0; i < numSamples; ++i)
+            channelData[i] *= (SampleType) getGain((float) channelData[i], envelope);
+
+        envelopes[ch] = envelope;
+    }
+}
+
+template void SlapsCompressor::process<float>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void SlapsCompressor::process<double>(const juce::dsp::ProcessContextReplacing<double>&) noexcept;
+
+void SlapsCompressor::processInterleaved(float* groupData, size_t numSamples, size_t firstChannel) noexcept
+{
+    static_assert(numLanes % 4 == 0, "the lanes get done four at a time");
+    static constexpr size_t numQuads = numLanes / 4;
+
+    jassert(firstChannel % numLanes == 0 && firstChannel < envelopes.size());
+
+    std::array<FourFloats, numQuads> envelope, threshold;
+
+    for (size_t quad = 0; quad < numQuads; ++quad)
+    {
+        envelope[quad] = FourFloats::load(envelopes.data() + firstChannel + quad * 4);
+        threshold[quad] = FourFloats::load(laneThresholdsLog2.data() + quad * 4);
+    }
+
+    auto attack = FourFloats::expand(attackCoefficient), release = FourFloats::expand(releaseCoefficient);
+    auto ratioSlope = FourFloats::expand(slope);
+    auto knee = FourFloats::expand(kneeLog2), halfKnee = FourFloats::expand(halfKneeLog2), kneeSquareScale = FourFloats::expand(kneeScale);
+    auto zero = FourFloats::expand(0.0f);
+
+    //exactly what getGain does, a whole group of channels per step
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        auto* frame = groupData + i * numLanes;
+
+        for (size_t quad = 0; quad < numQuads; ++quad)
+        {
+            auto input = FourFloats::load(frame + quad * 4);
+            auto& env = envelope[quad];
+
+            auto rectified = FourFloats::abs(input);
+            auto coefficient = FourFloats::selectGreater(rectified, env, attack, release);
+            env = rectified + coefficient * (env - rectified);
+
+            auto overshoot = fastLog2Lanes(env) - threshold[quad];
+            auto inKnee = FourFloats::min(knee, FourFloats::max(zero, overshoot + halfKnee));
+            auto reduction = ratioSlope * (inKnee * inKnee * kneeSquareScale + FourFloats::max(zero, overshoot - halfKnee));
+
+            (input * fastExp2Lanes(reduction)).store(frame + quad * 4);
+        }
+    }
+
+    for (size_t quad = 0; quad < numQuads; ++quad)
+        envelope[quad].store(envelopes.data() + firstChannel + quad * 4);
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    SlapsCompressor.h
+
+    The Slaps compressor. It's the same peak detector and gain computer as
+    juce::dsp::Compressor (which is what Slaps used before), but the gain
+    computer works in log2 with cheap polynomial log2/exp2 instead of
+    std::pow, it has an optional soft knee, and it can run on interleaved
+    audio so one pass handles a whole group of channels, one per lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class SlapsCompressor
+{
+public:
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t maxNumChannels = 16;
+    static constexpr size_t numLanes = SIMDFloat::size();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    //all cheap enough to call from the audio thread
+    void setThreshold(float newThresholdDecibels) noexcept;
+
+    //processInterleaved only, for when the lanes are different signals rather than channels of one,
+    //like the bands in MultibandCompressor. setThreshold puts every lane back to the same threshold
+    void setLaneThreshold(size_t lane, float newThresholdDecibels) noexcept;
+    void setRatio(float newRatio) noexcept;
+    void setAttack(float newAttackMs) noexcept;
+    void setRelease(float newReleaseMs) noexcept;
+    void setKnee(float newKneeDecibels) noexcept;
+
+    //how long the envelope takes to release from full scale down to decayGain
+    int getReleaseSamples(float decayGain) const noexcept;
+
+    //channel by channel, for the staged path. in double the gain still gets worked out in float,
+    //which is already far more accurate than anyone can hear, and only the audio stays double
+    template <typename SampleType>
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    //a group of channels interleaved the same way as FilterEngine does it, so sample i of
+    //channel firstChannel + lane is at groupData[i * numLanes + lane]
+    void processInterleaved(float* groupData, size_t numSamples, size_t firstChannel) noexcept;
+
+    //==============================================================================
+    //log2 and 2^x good to a few millionths of a dB, plenty for a gain computer
+    static float fastLog2(float x) noexcept
+    {
+        auto bits = toBits(x);
+        auto exponent = (float) ((int32_t) (bits >> 23) - 127);
+        auto t = fromBits((bits & 0x007fffffu) | 0x3f800000u) - 1.0f;
+
+        //log2(1 + t) on [0, 1)
+        auto poly = ((((( -0.0252855056f * t + 0.1201002580f) * t - 0.2759689553f) * t
+                        + 0.4565404101f) * t - 0.7179134799f) * t + 1.4425272727f) * t;
+
+        return exponent + poly;
+    }
+
+    static float fastExp2(float x) noexcept
+    {
+        x = juce::jlimit(-126.0f, 126.0f, x);
+
+        //floor without calling std::floor, so the lane loops still vectorise without SSE4.1
+        auto whole = (float) (int32_t) x;
+        whole -= x < whole ? 1.0f : 0.0f;
+        auto t = x - whole;
+
+        //2^t on [0, 1), exactly 1 at t = 0 so no reduction means exactly unity gain
+        auto poly = ((((0.0018955585f * t + 0.0089505589f) * t + 0.0558533533f) * t
+                       + 0.2401475577f) * t + 0.6931529716f) * t + 1.0f;
+
+        return fromBits(toBits(poly) + ((uint32_t) (int32_t) whole << 23));
+    }
+
+private:
+    static uint32_t toBits(float x) noexcept     { uint32_t bits; std::memcpy(&bits, &x, sizeof(bits)); return bits; }
+    static float fromBits(uint32_t bits) noexcept { float x; std::memcpy(&x, &bits, sizeof(x)); return x; }
+
+    static constexpr size_t maxNumGroups = (maxNumChannels + numLanes - 1) / numLanes;
+
+    //one channel's worth: follow the peak envelope, then work out the gain in log2
+    float getGain(float input, float& envelope) const noexcept
+    {
+        auto rectified = std::abs(input);
+        auto coefficient = rectified > envelope ? attackCoefficient : releaseCoefficient;
+        envelope = rectified + coefficient * (envelope - rectified);
+
+        //how far over the threshold we are, then the knee without any branches:
+        //below the knee both terms are 0, inside it the square takes over and above it they add up to the overshoot
+        auto overshoot = fastLog2(envelope) - thresholdLog2;
+        auto inKnee = juce::jlimit(0.0f, kneeLog2, overshoot + halfKneeLog2);
+        auto reduction = slope * (inKnee * inKnee * kneeScale + juce::jmax(0.0f, overshoot - halfKneeLog2));
+
+        return fastExp2(reduction);
+    }
+
+    void updateBallistics() noexcept;
+    void updateKnee() noexcept;
+
+    double sampleRate = 44100.0;
+    float thresholdDecibels = 0.0f, ratio = 10.0f, attackMs = 40.0f, releaseMs = 200.0f, kneeDecibels = 0.0f;
+
+    //the same numbers in the form getGain wants them
+    float thresholdLog2 = 0.0f, slope = -0.9f, attackCoefficient = 0.0f, releaseCoefficient = 0.0f;
+    float kneeLog2 = 0.0f, halfKneeLog2 = 0.0f, kneeScale = 0.0f;
+
+    //padded out to whole groups so the interleaved path can always take numLanes at once
+    std::array<float, maxNumGroups * numLanes> envelopes{};
+
+    //thresholdLog2 again for each lane of a group, unless setLaneThreshold has moved some
+    std::array<float, numLanes> laneThresholdsLog2{};
+
+    JUCE_LEAK_DETECTOR(SlapsCompressor)
+};
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    SnapshotSlot.h
+
+    A single value handed from one producer thread to one consumer thread
+    without locks. It's a triple buffer: the producer always has a spare copy
+    to write into, the consumer always has the one it last picked up, and the
+    third sits in the middle waiting to be swapped by whoever gets there next.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename Type>
+class SnapshotSlot
+{
+public:
+    static_assert(std::is_trivially_copyable<Type>::value, "snapshots get copied around on the audio thread, keep them plain data");
+
+    SnapshotSlot() = default;
+
+    //producer side: hands over a new value, replacing anything the consumer hasn't picked up yet
+    void publish(const Type& newValue) noexcept
+    {
+        buffers[(size_t) back] = newValue;
+        back = middle.exchange(back | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    //consumer side: if something new has arrived since the last call, copies it into dest and returns true
+    bool pull(Type& dest) noexcept
+    {
+        if ((middle.load(std::memory_order_acquire) & freshFlag) == 0)
+            return false;
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        dest = buffers[(size_t) front];
+        return true;
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<Type, 3> buffers{};
+    int back = 0, front = 1;
+    std::atomic<int> middle{ 2 };
+
+    JUCE_DECLARE_NON_COPYABLE(SnapshotSlot)
+};
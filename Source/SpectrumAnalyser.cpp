@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    if (registered)
+        analyserThread->removeTimeSliceClient(this);
+}
+
+float SpectrumAnalyser::getPointFrequency(int point) noexcept
+{
+    return minFrequency * std::pow(maxFrequency / minFrequency, (float) point / (float) (numPoints - 1));
+}
+
+void SpectrumAnalyser::prepare(double sampleRate)
+{
+    //the analyser thread mustn't be halfway through a frame while everything gets resized
+    const juce::ScopedLock sl(analysisLock);
+    pushingBlock = false;
+
+    //about 10 Hz per bin whatever the rate, so the low end of a kick still gets a few points of its own
+    auto fftOrder = juce::jlimit(11, 15, juce::roundToInt(std::log2(sampleRate / 10.0)));
+    auto fftSize = 1 << fftOrder;
+
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+    fftBuffer.assign((size_t) fftSize * 2, 0.0f);
+
+    window.assign((size_t) fftSize, 0.0f);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t) fftSize,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+
+    //so a full scale sine reads 0 dB whatever the window did to it
+    magnitudeScale = 2.0f / std::accumulate(window.begin(), window.end(), 0.0f);
+
+    for (int signal = 0; signal < numSignals; ++signal)
+    {
+        fifos[(size_t) signal].reset();
+        fifoBuffers[(size_t) signal].assign((size_t) fifoSize, 0.0f);
+        histories[(size_t) signal].assign((size_t) fftSize, 0.0f);
+        frame.decibels[(size_t) signal].fill(minDecibels);
+    }
+
+    historyPosition = 0;
+    samplesSinceFrame = 0;
+    hopSize = juce::jmax(1, juce::roundToInt(sampleRate / framesPerSecond));
+
+    //each point covers half way to its neighbours either side, in log frequency
+    auto binWidth = (float) sampleRate / (float) fftSize;
+    auto halfStep = std::pow(maxFrequency / minFrequency, 0.5f / (float) (numPoints - 1));
+    auto lastBin = fftSize / 2;
+
+    pointBins.resize((size_t) numPoints);
+
+    for (int point = 0; point < numPoints; ++point)
+    {
+        auto frequency = getPointFrequency(point);
+        auto& bins = pointBins[(size_t) point];
+
+        bins.start = juce::jlimit(0, lastBin, (int) std::ceil(frequency / halfStep / binWidth));
+        bins.end = juce::jlimit(0, lastBin, (int) std::floor(frequency * halfStep / binWidth));
+        bins.position = juce::jlimit(0.0f, (float) (lastBin - 1), frequency / binWidth);
+    }
+}
+
+void SpectrumAnalyser::setActive(bool shouldBeActive)
+{
+    active.store(shouldBeActive);
+
+    if (shouldBeActive && ! registered)
+    {
+        analyserThread->addTimeSliceClient(this);
+        registered = true;
+    }
+    else if (! shouldBeActive && registered)
+    {
+        //waits for a frame that's already going to finish
+        analyserThread->removeTimeSliceClient(this);
+        registered = false;
+    }
+}
+
+int SpectrumAnalyser::useTimeSlice()
+{
+    const juce::ScopedTryLock sl(analysisLock);
+
+    if (! sl.isLocked() || fft == nullptr)
+        return 50;
+
+    auto historySize = (int) histories[0].size();
+
+    //both signals get pushed the same blocks, but the audio thread could be between a block's input and its
+    //output right now. reading only as much as both have keeps them in step, sharing a write position
+    auto numRead = juce::jmin(fifos[(size_t) input].getNumReady(), fifos[(size_t) output].getNumReady());
+
+    for (int signal = 0; signal < numSignals; ++signal)
+    {
+        auto& fifo = fifos[(size_t) signal];
+        auto& history = histories[(size_t) signal];
+        auto* data = fifoBuffers[(size_t) signal].data();
+        auto position = historyPosition;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(numRead, start1, size1, start2, size2);
+
+        for (auto [start, size] : { std::pair<int, int>(start1, size1), std::pair<int, int>(start2, size2) })
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                history[(size_t) position] = data[start + i];
+                position = (position + 1) % historySize;
+            }
+        }
+
+        fifo.finishedRead(size1 + size2);
+    }
+
+    historyPosition = (historyPosition + numRead) % historySize;
+    samplesSinceFrame += numRead;
+
+    if (samplesSinceFrame < hopSize)
+        return 10;
+
+    samplesSinceFrame %= hopSize;
+
+    for (int signal = 0; signal < numSignals; ++signal)
+        analyse((Signal) signal);
+
+    frames.publish(frame);
+    return 10;
+}
+
+void SpectrumAnalyser::analyse(Signal signal)
+{
+    auto& history = histories[(size_t) signal];
+    auto size = history.size();
+
+    //oldest sample first, windowed
+    for (size_t i = 0; i < size; ++i)
+        fftBuffer[i] = history[((size_t) historyPosition + i) % size] * window[i];
+
+    std::fill(fftBuffer.begin() + (ptrdiff_t) size, fftBuffer.end(), 0.0f);
+    fft->performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+
+    auto& decibels = frame.decibels[(size_t) signal];
+
+    for (int point = 0; point < numPoints; ++point)
+    {
+        auto& bins = pointBins[(size_t) point];
+        float magnitude;
+
+        if (bins.end >= bins.start)
+        {
+            magnitude = *std::max_element(fftBuffer.begin() + bins.start, fftBuffer.begin() + bins.end + 1);
+        }
+        else
+        {
+            auto bin = (int) bins.position;
+            auto fraction = bins.position - (float) bin;
+            magnitude = fftBuffer[(size_t) bin] + fraction * (fftBuffer[(size_t) bin + 1] - fftBuffer[(size_t) bin]);
+        }
+
+        auto level = juce::Decibels::gainToDecibels(magnitude * magnitudeScale, minDecibels);
+        decibels[(size_t) point] = juce::jmax(level, decibels[(size_t) point] - releaseDecibelsPerFrame);
+    }
+}
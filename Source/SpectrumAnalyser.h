@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+
+    The input and output spectra for the editor. All the audio thread does
+    is mix each block down to mono and drop it into a lock free FIFO, and
+    only while an editor is actually showing it. A background thread shared
+    by every instance drains the FIFOs, and about 30 times a second it
+    windows the latest fftSize samples, runs the FFT, bins it onto a fixed
+    set of log spaced points and smooths it. The finished frame gets handed
+    to the editor through a SnapshotSlot, so drawing it is just a copy.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SnapshotSlot.h"
+
+class SpectrumAnalyser : private juce::TimeSliceClient
+{
+public:
+    enum Signal { input, output, numSignals };
+
+    //log spaced from minFrequency to maxFrequency, so point i always sits at the same x on screen
+    static constexpr int numPoints = 256;
+    static constexpr float minFrequency = 20.0f, maxFrequency = 20000.0f;
+    static constexpr float minDecibels = -90.0f;
+
+    struct Frame
+    {
+        std::array<std::array<float, numPoints>, numSignals> decibels;
+    };
+
+    SpectrumAnalyser() = default;
+    ~SpectrumAnalyser() override;
+
+    //while the audio thread isn't running, from whatever thread the host prepares on. it leaves the
+    //active flag alone, that's only ever the editor's
+    void prepare(double sampleRate);
+
+    //audio thread: the first numChannels channels of buffer, summed to mono. free when nobody's watching.
+    //each block's input has to go in before its output, and the output only goes in if the input did
+    template <typename SampleType>
+    void push(Signal signal, const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+    //message thread: the editor turns this on while it's showing and off when it isn't
+    void setActive(bool shouldBeActive);
+
+    //message thread: true and the newest frame if there's been one since last time
+    bool pullFrame(Frame& dest) noexcept { return frames.pull(dest); }
+
+    static float getPointFrequency(int point) noexcept;
+
+private:
+    //one thread for every instance in the process, so lots of open editors can't add up to lots of threads
+    struct AnalyserThread : public juce::TimeSliceThread
+    {
+        AnalyserThread() : juce::TimeSliceThread("Slaps analyser") { startThread(); }
+        ~AnalyserThread() override { stopThread(2000); }
+    };
+
+    static constexpr double framesPerSecond = 30.0;
+    static constexpr int fifoSize = 1 << 15;
+
+    //how far each point falls per frame once the level drops away, rises are instant
+    static constexpr float releaseDecibelsPerFrame = 1.5f;
+
+    int useTimeSlice() override;
+    void analyse(Signal signal);
+
+    //audio thread writes, analyser thread reads
+    std::array<juce::AbstractFifo, numSignals> fifos{ { juce::AbstractFifo(fifoSize), juce::AbstractFifo(fifoSize) } };
+    std::array<std::vector<float>, numSignals> fifoBuffers;
+    std::atomic<bool> active{ false };
+
+    //audio thread only: whether this block's input went in, so its output goes in with it or not at all
+    bool pushingBlock = false;
+
+    //held by prepare while it resizes everything, the analyser thread skips a turn rather than waiting
+    juce::CriticalSection analysisLock;
+
+    //analyser thread only: the last fftSize samples of each signal as a ring, and what gets made from them
+    std::array<std::vector<float>, numSignals> histories;
+    int historyPosition = 0, samplesSinceFrame = 0, hopSize = 1;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftBuffer, window;
+
+    //which fft bins land on each point. a point narrower than a bin reads between the two nearest instead
+    struct PointBins
+    {
+        int start, end;
+        float position;
+    };
+
+    std::vector<PointBins> pointBins;
+    float magnitudeScale = 1.0f;
+    Frame frame;
+
+    SnapshotSlot<Frame> frames;
+
+    juce::SharedResourcePointer<AnalyserThread> analyserThread;
+    bool registered = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyser)
+};
+
+//==============================================================================
+template <typename SampleType>
+void SpectrumAnalyser::push(Signal signal, const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    auto numSamples = buffer.getNumSamples();
+
+    //the input and output go in as a pair. if the analyser's fallen behind and either won't fit, the whole
+    //block gets dropped from both so they never drift apart, it'll catch up on the next frame
+    if (signal == input)
+    {
+        pushingBlock = active.load(std::memory_order_relaxed) && numChannels > 0 && ! fifoBuffers[(size_t) input].empty()
+                    && fifos[(size_t) input].getFreeSpace() >= numSamples && fifos[(size_t) output].getFreeSpace() >= numSamples;
+    }
+
+    if (! pushingBlock)
+        return;
+
+    //the analyser thread only ever frees up space, so the output's still got room for what the input checked
+    if (signal == output)
+        pushingBlock = false;
+
+    auto& fifo = fifos[(size_t) signal];
+    auto* data = fifoBuffers[(size_t) signal].data();
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+    jassert(size1 + size2 == numSamples);
+
+    auto gain = 1.0f / (float) numChannels;
+
+    auto mixDown = [&] (int dest, int source, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        juce::FloatVectorOperations::clear(data + dest, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* in = buffer.getReadPointer(channel, source);
+
+            for (int i = 0; i < numSamples; ++i)
+                data[dest + i] += (float) in[i] * gain;
+        }
+    };
+
+    mixDown(start1, 0, size1);
+    mixDown(start2, size1, size2);
+
+    fifo.finishedWrite(size1 + size2);
+}
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumDisplay.h"
+
+SpectrumDisplay::SpectrumDisplay(SlapsAudioProcessor& p)
+    : audioProcessor(p)
+{
+    setOpaque(true);
+
+    instrumentParameter = audioProcessor.apvts.getRawParameterValue("INSTRUMENT");
+    slapParameter = audioProcessor.apvts.getRawParameterValue("SLAP");
+    bypassParameter = audioProcessor.apvts.getRawParameterValue("BYPASS");
+    lowCutSlopeParameter = audioProcessor.apvts.getRawParameterValue("LOW_CUT_SLOPE");
+    eqModeParameter = audioProcessor.apvts.getRawParameterValue("EQ_MODE");
+    characterParameter = audioProcessor.apvts.getRawParameterValue("CHARACTER");
+
+    for (auto& decibels : frame.decibels)
+        decibels.fill(SpectrumAnalyser::minDecibels);
+
+    eqDecibels.fill(0.0f);
+
+    //room for every point plus closing the fill off along the bottom, so rebuilding never allocates
+    for (auto* path : { &inputPath, &outputPath, &eqPath })
+        path->preallocateSpace(3 * (numPoints + 4));
+
+    startTimerHz(30);
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+    stopTimer();
+    audioProcessor.analyser.setActive(false);
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    //a line every decade and one at 0 dB on the eq scale
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+
+    for (auto frequency : { 100.0f, 1000.0f, 10000.0f })
+    {
+        auto x = (float) getWidth() * std::log(frequency / SpectrumAnalyser::minFrequency)
+                                    / std::log(SpectrumAnalyser::maxFrequency / SpectrumAnalyser::minFrequency);
+        g.drawVerticalLine(juce::roundToInt(x), 0.0f, (float) getHeight());
+    }
+
+    g.drawHorizontalLine(juce::roundToInt(getEqY(0.0f)), 0.0f, (float) getWidth());
+
+    g.setColour(juce::Colours::slategrey.withAlpha(0.6f));
+    g.fillPath(inputPath);
+
+    g.setColour(juce::Colours::orange);
+    g.strokePath(outputPath, juce::PathStrokeType(1.5f));
+
+    g.setColour(juce::Colours::yellow.withAlpha(0.8f));
+    g.strokePath(eqPath, juce::PathStrokeType(1.0f));
+}
+
+void SpectrumDisplay::resized()
+{
+    for (int point = 0; point < numPoints; ++point)
+        pointX[(size_t) point] = (float) getWidth() * (float) point / (float) (numPoints - 1);
+
+    rebuildPaths();
+}
+
+void SpectrumDisplay::timerCallback()
+{
+    //the analyser only runs while we're actually on screen
+    auto showing = isShowing();
+    audioProcessor.analyser.setActive(showing);
+
+    if (! showing)
+        return;
+
+    auto newFrame = audioProcessor.analyser.pullFrame(frame);
+    auto newCurve = updateEqCurve();
+
+    if (newFrame || newCurve)
+    {
+        rebuildPaths();
+        repaint();
+    }
+}
+
+bool SpectrumDisplay::updateEqCurve()
+{
+    auto sampleRate = audioProcessor.getSampleRate();
+
+    if (sampleRate <= 0)
+        return false;
+
+    auto instrument = audioProcessor.instrumentProfiles->resolve((int) instrumentParameter->load());
+    auto bypass = bypassParameter->load() >= 0.5f;
+    auto slope = (int) lowCutSlopeParameter->load();
+    auto morph = (int) eqModeParameter->load() == 2;
+    auto character = characterParameter->load();
+
+    //in morph mode the curve's CHARACTER's, in its 0.01 steps, which get numbered after the instruments
+    auto numCharacterSteps = juce::roundToInt(EqShape::maxCharacter * 100.0f) + 1;
+    auto numInstruments = audioProcessor.instrumentProfiles->size();
+    auto curveIndex = morph ? numInstruments + juce::roundToInt(character * 100.0f) : instrument;
+    auto curve = slope * (numInstruments + numCharacterSteps) + curveIndex;
+    auto key = bypass ? 0 : 1 + curve * CoefficientBank::numSlapSteps + CoefficientBank::getSlapIndex(slapParameter->load());
+
+    if (key == eqKey && sampleRate == eqSampleRate)
+        return false;
+
+    //the processor's already got a bank at this rate, so this just picks up the same one
+    if (sampleRate != eqSampleRate)
+    {
+        eqBank = CoefficientBank::getShared(sampleRate, audioProcessor.instrumentProfiles.get());
+        eqSampleRate = sampleRate;
+    }
+
+    eqKey = key;
+
+    if (bypass)
+    {
+        eqDecibels.fill(0.0f);
+        return true;
+    }
+
+    auto eq = morph ? EqShape::forCharacter(character).getCoefficients(sampleRate, slapParameter->load(), slope)
+                    : eqBank->get(instrument, slapParameter->load(), slope);
+
+    for (int point = 0; point < numPoints; ++point)
+    {
+        auto frequency = SpectrumAnalyser::getPointFrequency(point);
+
+        //past nyquist there's nothing to draw, just hold the last value
+        eqDecibels[(size_t) point] = frequency < sampleRate * 0.5
+                                   ? juce::Decibels::gainToDecibels((float) eq.getMagnitude(frequency, sampleRate))
+                                   : eqDecibels[(size_t) juce::jmax(0, point - 1)];
+    }
+
+    return true;
+}
+
+void SpectrumDisplay::rebuildPaths()
+{
+    auto bottom = (float) getHeight();
+    auto& input = frame.decibels[SpectrumAnalyser::input];
+    auto& output = frame.decibels[SpectrumAnalyser::output];
+
+    inputPath.clear();
+    outputPath.clear();
+    eqPath.clear();
+
+    inputPath.startNewSubPath(pointX[0], bottom);
+    outputPath.startNewSubPath(pointX[0], getSpectrumY(output[0]));
+    eqPath.startNewSubPath(pointX[0], getEqY(eqDecibels[0]));
+
+    for (size_t point = 0; point < (size_t) numPoints; ++point)
+    {
+        inputPath.lineTo(pointX[point], getSpectrumY(input[point]));
+
+        if (point > 0)
+        {
+            outputPath.lineTo(pointX[point], getSpectrumY(output[point]));
+            eqPath.lineTo(pointX[point], getEqY(eqDecibels[point]));
+        }
+    }
+
+    inputPath.lineTo(pointX[(size_t) numPoints - 1], bottom);
+    inputPath.closeSubPath();
+}
+
+float SpectrumDisplay::getSpectrumY(float decibels) const noexcept
+{
+    return juce::jmap(decibels, SpectrumAnalyser::minDecibels, maxDecibels, (float) getHeight(), 0.0f);
+}
+
+float SpectrumDisplay::getEqY(float decibels) const noexcept
+{
+    return juce::jmap(juce::jlimit(-eqRangeDecibels, eqRangeDecibels, decibels), -eqRangeDecibels, eqRangeDecibels, (float) getHeight(), 0.0f);
+}
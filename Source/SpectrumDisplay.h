@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    SpectrumDisplay.h
+
+    Draws what SpectrumAnalyser hands over: the input filled in underneath,
+    the output on top of it and the current instrument's eq curve over
+    both. The x of every point is worked out once per resize, so a new
+    frame is just numPoints y values going into paths that never grow.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+class SpectrumDisplay : public juce::Component,
+                        private juce::Timer
+{
+public:
+    explicit SpectrumDisplay(SlapsAudioProcessor&);
+    ~SpectrumDisplay() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+
+    //only redoes the curve when the instrument, slap, slope, bypass or rate has actually changed, true if it did
+    bool updateEqCurve();
+    void rebuildPaths();
+
+    static constexpr int numPoints = SpectrumAnalyser::numPoints;
+    static constexpr float maxDecibels = 6.0f;
+
+    //the eq curve gets its own scale, the spectrum one would flatten it out
+    static constexpr float eqRangeDecibels = 24.0f;
+
+    float getSpectrumY(float decibels) const noexcept;
+    float getEqY(float decibels) const noexcept;
+
+    SlapsAudioProcessor& audioProcessor;
+    std::atomic<float>* instrumentParameter = nullptr;
+    std::atomic<float>* slapParameter = nullptr;
+    std::atomic<float>* bypassParameter = nullptr;
+    std::atomic<float>* lowCutSlopeParameter = nullptr;
+    std::atomic<float>* eqModeParameter = nullptr;
+    std::atomic<float>* characterParameter = nullptr;
+
+    SpectrumAnalyser::Frame frame;
+    std::array<float, numPoints> pointX{}, eqDecibels{};
+    juce::Path inputPath, outputPath, eqPath;
+
+    //kept hold of so the curve doesn't have to go looking for the bank every time slap moves
+    std::shared_ptr<const CoefficientBank> eqBank;
+    double eqSampleRate = 0;
+    int eqKey = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumDisplay)
+};
@@ -0,0 +1,427 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "RenderJob.h"
+
+#if JUCE_WINDOWS
+ #define NOMINMAX
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment (lib, "psapi.lib")
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_LINUX
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    //how much memory the whole process is holding right now, 0 if we can't tell on this platform
+    juce::int64 getResidentMemoryBytes()
+    {
+       #if JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters;
+
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return (juce::int64) counters.WorkingSetSize;
+       #elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+            return (juce::int64) info.resident_size;
+       #elif JUCE_LINUX
+        auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), false);
+
+        if (fields.size() > 1)
+            return fields[1].getLargeIntValue() * (juce::int64) sysconf(_SC_PAGESIZE);
+       #endif
+
+        return 0;
+    }
+
+    double ticksToNanoseconds(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9;
+    }
+
+    //sorts the timings in place and pulls out the percentiles we care about, in microseconds
+    juce::DynamicObject* summariseTimes(std::vector<double>& nanos)
+    {
+        std::sort(nanos.begin(), nanos.end());
+
+        auto percentile = [&nanos] (double p) { return nanos[(size_t) juce::roundToInt(p * (double) (nanos.size() - 1))] / 1000.0; };
+
+        double total = 0;
+
+        for (auto n : nanos)
+            total += n;
+
+        auto* summary = new juce::DynamicObject();
+        summary->setProperty("meanMicroseconds", total / (double) nanos.size() / 1000.0);
+        summary->setProperty("p50Microseconds", percentile(0.5));
+        summary->setProperty("p90Microseconds", percentile(0.9));
+        summary->setProperty("p99Microseconds", percentile(0.99));
+        summary->setProperty("p999Microseconds", percentile(0.999));
+        summary->setProperty("maxMicroseconds", nanos.back() / 1000.0);
+
+        return summary;
+    }
+
+    juce::var summariseBlockTimes(std::vector<double>& nanos, double blockPeriodSeconds)
+    {
+        auto* summary = summariseTimes(nanos);
+        auto p99 = (double) summary->getProperty("p99Microseconds");
+        summary->setProperty("p99PercentOfBlockPeriod", p99 / (blockPeriodSeconds * 1.0e6) * 100.0);
+
+        return summary;
+    }
+
+    //the same noise goes through every case so runs are comparable
+    juce::AudioBuffer<float> makeNoise(int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> noise(numChannels, numSamples);
+        juce::Random random(0x5145);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+
+        return noise;
+    }
+
+    RenderSettings makeSettings(bool useFusedKernel, int instrument, bool bypass)
+    {
+        RenderSettings settings;
+        settings.useFusedKernel = useFusedKernel;
+        settings.parameters.set("INSTRUMENT", instrument);
+        settings.parameters.set("SLAP", 12.0f);
+        settings.parameters.set("BYPASS", bypass ? 1.0f : 0.0f);
+        return settings;
+    }
+
+    //==============================================================================
+    juce::var runCase(const RenderSettings& settings, int numChannels, double sampleRate, int blockSize,
+                      double secondsOfAudio, const juce::AudioBuffer<float>& noise)
+    {
+        SlapsAudioProcessor processor;
+
+        if (! setChannelLayout(processor, numChannels))
+        {
+            jassertfalse;
+            return {};
+        }
+
+        applyRenderSettings(processor, settings);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        auto numBlocks = juce::jmax(32, (int) (secondsOfAudio * sampleRate / blockSize));
+        auto numWarmupBlocks = 8;
+        auto noiseLength = noise.getNumSamples() - blockSize;
+
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+        juce::MidiBuffer midiMessages;
+
+        std::vector<double> blockNanos;
+        blockNanos.reserve((size_t) numBlocks);
+
+        for (int block = 0; block < numBlocks + numWarmupBlocks; ++block)
+        {
+            auto offset = (block * blockSize) % noiseLength;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                buffer.copyFrom(ch, 0, noise, ch % noise.getNumChannels(), offset, blockSize);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midiMessages);
+            auto end = juce::Time::getHighResolutionTicks();
+
+            if (block >= numWarmupBlocks)
+                blockNanos.push_back(ticksToNanoseconds(end - start));
+        }
+
+        processor.releaseResources();
+
+        double total = 0;
+
+        for (auto n : blockNanos)
+            total += n;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("channels", numChannels);
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("blockSize", blockSize);
+        result->setProperty("instrument", processor.apvts.getParameter("INSTRUMENT")->getCurrentValueAsText());
+        result->setProperty("bypass", processor.apvts.getParameter("BYPASS")->getValue() >= 0.5f);
+        result->setProperty("nsPerSample", total / ((double) blockNanos.size() * blockSize));
+        result->setProperty("nsPerChannelSample", total / ((double) blockNanos.size() * blockSize * numChannels));
+        result->setProperty("blocks", summariseBlockTimes(blockNanos, blockSize / sampleRate));
+
+        return result;
+    }
+
+    //lots of stereo instances side by side in one graph, like a big session would have
+    juce::var runScalingTest(bool useFusedKernel, int numInstances, double sampleRate, int blockSize, double secondsOfAudio,
+                             const juce::AudioBuffer<float>& noise)
+    {
+        using IONode = juce::AudioProcessorGraph::AudioGraphIOProcessor;
+
+        auto memoryBefore = getResidentMemoryBytes();
+        auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        juce::AudioProcessorGraph graph;
+        graph.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+
+        auto input = graph.addNode(std::make_unique<IONode>(IONode::audioInputNode));
+        auto output = graph.addNode(std::make_unique<IONode>(IONode::audioOutputNode));
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto processor = std::make_unique<SlapsAudioProcessor>();
+            applyRenderSettings(*processor, makeSettings(useFusedKernel, 1 + i % 3, false));
+
+            auto node = graph.addNode(std::move(processor));
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                graph.addConnection({ { input->nodeID, ch }, { node->nodeID, ch } });
+                graph.addConnection({ { node->nodeID, ch }, { output->nodeID, ch } });
+            }
+        }
+
+        graph.prepareToPlay(sampleRate, blockSize);
+
+        auto setupSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        auto memoryAfter = getResidentMemoryBytes();
+
+        auto numBlocks = juce::jmax(32, (int) (secondsOfAudio * sampleRate / blockSize));
+        auto noiseLength = noise.getNumSamples() - blockSize;
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midiMessages;
+
+        std::vector<double> blockNanos;
+        blockNanos.reserve((size_t) numBlocks);
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto offset = (block * blockSize) % noiseLength;
+
+            for (int ch = 0; ch < 2; ++ch)
+                buffer.copyFrom(ch, 0, noise, ch % noise.getNumChannels(), offset, blockSize);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            graph.processBlock(buffer, midiMessages);
+            blockNanos.push_back(ticksToNanoseconds(juce::Time::getHighResolutionTicks() - start));
+        }
+
+        graph.releaseResources();
+
+        double total = 0;
+
+        for (auto n : blockNanos)
+            total += n;
+
+        auto cpuPercent = total / 1.0e9 / (numBlocks * blockSize / sampleRate) * 100.0;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("instances", numInstances);
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("blockSize", blockSize);
+        result->setProperty("setupSeconds", setupSeconds);
+        result->setProperty("totalCpuPercent", cpuPercent);
+        result->setProperty("cpuPercentPerInstance", cpuPercent / numInstances);
+        result->setProperty("memoryBytesPerInstance", memoryAfter > 0 ? (double) (memoryAfter - memoryBefore) / numInstances : 0.0);
+        result->setProperty("blocks", summariseBlockTimes(blockNanos, blockSize / sampleRate));
+
+        return result;
+    }
+
+    //how the plugin saved its state before the binary format, kept here to compare against
+    void getLegacyState(SlapsAudioProcessor& processor, juce::MemoryBlock& destData)
+    {
+        auto state = processor.apvts.copyState();
+        std::unique_ptr<juce::XmlElement> xml(state.createXml());
+        juce::AudioProcessor::copyXmlToBinary(*xml, destData);
+    }
+
+    //saves then restores every instance with one format, returning the save and restore timings and the blob size
+    juce::var runStateCase(juce::OwnedArray<SlapsAudioProcessor>& processors, bool binary, int numRounds)
+    {
+        std::vector<double> saveNanos, restoreNanos;
+        juce::MemoryBlock blob;
+
+        for (int round = 0; round < numRounds; ++round)
+        {
+            for (auto* processor : processors)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+
+                if (binary)
+                    processor->getStateInformation(blob);
+                else
+                    getLegacyState(*processor, blob);
+
+                auto saved = juce::Time::getHighResolutionTicks();
+
+                //setStateInformation picks the old XML path on its own when the blob isn't binary
+                processor->setStateInformation(blob.getData(), (int) blob.getSize());
+
+                auto restored = juce::Time::getHighResolutionTicks();
+
+                saveNanos.push_back(ticksToNanoseconds(saved - start));
+                restoreNanos.push_back(ticksToNanoseconds(restored - saved));
+            }
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("format", binary ? "binary" : "xml");
+        result->setProperty("bytes", (int) blob.getSize());
+        result->setProperty("save", summariseTimes(saveNanos));
+        result->setProperty("restore", summariseTimes(restoreNanos));
+
+        return result;
+    }
+
+    juce::Array<int> parseIntList(const juce::String& list)
+    {
+        juce::Array<int> values;
+
+        for (auto& token : juce::StringArray::fromTokens(list, ",", {}))
+            if (token.trim().isNotEmpty())
+                values.add(token.getIntValue());
+
+        return values;
+    }
+    //as JSON, to --bench-out if it's given and stdout if not. returns the exit code for main
+    int writeReport(const juce::var& report, const juce::ArgumentList& args)
+    {
+        auto json = juce::JSON::toString(report);
+
+        if (args.containsOption("--bench-out"))
+        {
+            auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--bench-out"));
+
+            if (! file.replaceWithText(json))
+            {
+                std::cerr << "couldn't write " << file.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cout << json << std::endl;
+        }
+
+        return 0;
+    }
+}
+
+//==============================================================================
+int runBenchmarks(const juce::ArgumentList& args)
+{
+    auto secondsPerCase = args.containsOption("--bench-seconds") ? args.getValueForOption("--bench-seconds").getDoubleValue() : 1.0;
+
+    juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    juce::Array<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    juce::Array<int> channelCounts { 1, 2, 6, 12 };
+    juce::Array<int> instanceCounts { 1, 10, 100, 250, 500 };
+
+    if (args.containsOption("--bench-blocks"))
+        blockSizes = parseIntList(args.getValueForOption("--bench-blocks"));
+
+    if (args.containsOption("--bench-channels"))
+        channelCounts = parseIntList(args.getValueForOption("--bench-channels"));
+
+    if (args.containsOption("--bench-instances"))
+        instanceCounts = parseIntList(args.getValueForOption("--bench-instances"));
+
+    auto useFusedKernel = ! args.containsOption("--staged");
+    auto noise = makeNoise(2, 1 << 18);
+    juce::var cases { juce::Array<juce::var>() }, scaling { juce::Array<juce::var>() };
+
+    for (auto numChannels : channelCounts)
+    {
+        {
+            SlapsAudioProcessor probe;
+
+            if (! setChannelLayout(probe, numChannels))
+            {
+                std::cerr << "skipping " << numChannels << " channels, Slaps doesn't support that layout" << std::endl;
+                continue;
+            }
+        }
+
+        auto channelNoise = numChannels == noise.getNumChannels() ? noise : makeNoise(numChannels, noise.getNumSamples());
+
+        for (auto sampleRate : sampleRates)
+            for (auto blockSize : blockSizes)
+                for (int instrument = 0; instrument < InstrumentProfiles::numBuiltIn; ++instrument)
+                    for (auto bypass : { false, true })
+                        cases.append(runCase(makeSettings(useFusedKernel, instrument, bypass), numChannels,
+                                             sampleRate, blockSize, secondsPerCase, channelNoise));
+    }
+
+    for (auto numInstances : instanceCounts)
+        scaling.append(runScalingTest(useFusedKernel, numInstances, 48000.0, 256, secondsPerCase, noise));
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("plugin", JucePlugin_Name);
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("numCpus", juce::SystemStats::getNumCpus());
+    report->setProperty("fusedKernel", useFusedKernel);
+    report->setProperty("cases", cases);
+    report->setProperty("scaling", scaling);
+
+    //always 0 unless it was built with SLAPS_RT_CHECKS, which the Debug config is
+    report->setProperty("realtimeViolations", RealtimeChecks::getNumViolations());
+
+    return writeReport(juce::var(report), args);
+}
+
+//==============================================================================
+int runStateBenchmark(const juce::ArgumentList& args)
+{
+    auto instanceCounts = args.containsOption("--bench-instances") ? parseIntList(args.getValueForOption("--bench-instances"))
+                                                                   : juce::Array<int> { 1, 100, 500 };
+    auto numRounds = 20;
+
+    juce::var cases { juce::Array<juce::var>() };
+
+    for (auto numInstances : instanceCounts)
+    {
+        //every instance set up a bit differently, like a real session
+        juce::OwnedArray<SlapsAudioProcessor> processors;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto* processor = processors.add(new SlapsAudioProcessor());
+            auto settings = makeSettings(true, i % InstrumentProfiles::numBuiltIn, false);
+            settings.parameters.set("SLAP", (float) (i % 36));
+            settings.parameters.set("GAIN", (float) (i % 12) - 6.0f);
+            applyRenderSettings(*processor, settings);
+        }
+
+        for (auto binary : { false, true })
+        {
+            auto result = runStateCase(processors, binary, numRounds);
+            result.getDynamicObject()->setProperty("instances", numInstances);
+            cases.append(result);
+        }
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("plugin", JucePlugin_Name);
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("rounds", numRounds);
+    report->setProperty("cases", cases);
+
+    return writeReport(juce::var(report), args);
+}
@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+
+    SlapsRender --benchmark: times processBlock across block sizes, sample
+    rates, channel layouts, instruments and bypass, then loads hundreds of
+    instances into an AudioProcessorGraph to see how it scales. Everything
+    comes out as JSON so runs can be diffed.
+
+    SlapsRender --bench-state: times saving and restoring state per
+    instance, in the binary format and the old XML one, across a big
+    session's worth of instances.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//returns the exit code for main, runs on the message thread
+int runBenchmarks(const juce::ArgumentList& args);
+int runStateBenchmark(const juce::ArgumentList& args);
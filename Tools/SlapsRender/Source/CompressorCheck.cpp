@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    CompressorCheck.cpp
+
+  ==============================================================================
+*/
+
+#include "CompressorCheck.h"
+#include "../../../Source/SlapsCompressor.h"
+
+namespace
+{
+    constexpr int numChannels = 4;
+
+    //quiet noise with loud bursts and a sine sweeping through the threshold, so the envelope
+    //spends time attacking, releasing and sitting still both above and below the threshold
+    juce::AudioBuffer<float> makeTestSignal(double sampleRate)
+    {
+        auto numSamples = (int) sampleRate * 4;
+        juce::AudioBuffer<float> signal(numChannels, numSamples);
+        juce::Random random(0x51a95);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = signal.getWritePointer(channel);
+            auto burstLength = (int) (sampleRate * 0.01);
+            auto burstSpacing = (int) (sampleRate * 0.25) + channel * 997;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto position = (float) i / (float) numSamples;
+                auto sweep = juce::Decibels::decibelsToGain(-40.0f + 52.0f * position)
+                           * std::sin(juce::MathConstants<float>::twoPi * 220.0f * (float) (channel + 1) * (float) i / (float) sampleRate);
+                auto noise = (random.nextFloat() * 2.0f - 1.0f) * ((i % burstSpacing) < burstLength ? 4.0f : 0.05f);
+
+                data[i] = sweep + noise;
+            }
+        }
+
+        return signal;
+    }
+
+    struct CheckResult
+    {
+        float maxDecibels = 0.0f, maxInterleavedDifference = 0.0f;
+    };
+
+    CheckResult checkOne(const juce::AudioBuffer<float>& signal, double sampleRate, float thresholdDecibels)
+    {
+        auto numSamples = signal.getNumSamples();
+        juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32) numSamples, (juce::uint32) numChannels };
+
+        //the old compressor, set up the way the plugin had it hard coded
+        juce::dsp::Compressor<float> reference;
+        reference.prepare(spec);
+        reference.setThreshold(thresholdDecibels);
+        reference.setRatio(10.0f);
+        reference.setAttack(40.0f);
+        reference.setRelease(200.0f);
+
+        SlapsCompressor staged, interleaved;
+
+        for (auto* compressor : { &staged, &interleaved })
+        {
+            compressor->prepare(spec);
+            compressor->setThreshold(thresholdDecibels);
+            compressor->setRatio(10.0f);
+            compressor->setAttack(40.0f);
+            compressor->setRelease(200.0f);
+            compressor->setKnee(0.0f);
+        }
+
+        juce::AudioBuffer<float> expected(signal), actual(signal);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = expected.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = reference.processSample(channel, data[i]);
+        }
+
+        juce::dsp::AudioBlock<float> actualBlock(actual);
+        staged.process(juce::dsp::ProcessContextReplacing<float>(actualBlock));
+
+        //and the same again through the interleaved path, one group of lanes at a time
+        constexpr auto lanes = SlapsCompressor::numLanes;
+        auto numGroups = (numChannels + (int) lanes - 1) / (int) lanes;
+        std::vector<float> wide((size_t) numGroups * lanes * (size_t) numSamples, 0.0f);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                wide[((size_t) (channel / (int) lanes) * (size_t) numSamples + (size_t) i) * lanes + (size_t) channel % lanes] = signal.getSample(channel, i);
+
+        for (int group = 0; group < numGroups; ++group)
+            interleaved.processInterleaved(wide.data() + (size_t) group * (size_t) numSamples * lanes, (size_t) numSamples, (size_t) group * lanes);
+
+        CheckResult result;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto want = std::abs(expected.getSample(channel, i));
+                auto got = actual.getSample(channel, i);
+                auto gotInterleaved = wide[((size_t) (channel / (int) lanes) * (size_t) numSamples + (size_t) i) * lanes + (size_t) channel % lanes];
+
+                //below -120 dB the ratio stops meaning much
+                if (want > 1.0e-6f)
+                    result.maxDecibels = juce::jmax(result.maxDecibels, std::abs(juce::Decibels::gainToDecibels(std::abs(got) / want, -1000.0f)));
+
+                result.maxInterleavedDifference = juce::jmax(result.maxInterleavedDifference, std::abs(gotInterleaved - got));
+            }
+        }
+
+        return result;
+    }
+}
+
+int runCompressorCheck(const juce::ArgumentList& args)
+{
+    auto tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getFloatValue() : 0.001f;
+    auto failed = false;
+
+    for (auto sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+    {
+        auto signal = makeTestSignal(sampleRate);
+
+        //the slap knob goes -6 to 36, and the threshold is half of that going the other way
+        for (auto slap = -6.0f; slap <= 36.0f; slap += 6.0f)
+        {
+            auto threshold = slap * -0.5f;
+            auto result = checkOne(signal, sampleRate, threshold);
+            auto ok = result.maxDecibels <= tolerance && result.maxInterleavedDifference <= 1.0e-6f;
+
+            std::cout << (ok ? "ok   " : "FAIL ") << sampleRate << " Hz, threshold " << threshold << " dB: "
+                      << result.maxDecibels << " dB from juce::dsp::Compressor, interleaved differs by "
+                      << result.maxInterleavedDifference << std::endl;
+
+            failed = failed || ! ok;
+        }
+    }
+
+    std::cout << (failed ? "compressor is out of tolerance" : "compressor matches") << " (tolerance " << tolerance << " dB)" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+/*
+  ==============================================================================
+
+    CompressorCheck.h
+
+    SlapsRender --check-compressor: runs SlapsCompressor next to the
+    juce::dsp::Compressor it replaced, at the plugin's default compressor
+    settings over the whole range of the slap knob, and fails if the two
+    ever drift further apart than the tolerance.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//returns the exit code for main, non zero if anything was out of tolerance
+int runCompressorCheck(const juce::ArgumentList& args);
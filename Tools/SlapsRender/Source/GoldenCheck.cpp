@@ -0,0 +1,527 @@
+/*
+  ==============================================================================
+
+    GoldenCheck.cpp
+
+  ==============================================================================
+*/
+
+#include "GoldenCheck.h"
+#include "RenderJob.h"
+
+namespace
+{
+    //where each part of the test signal starts, so the reports can look at the bit that matters
+    struct TestSignal
+    {
+        juce::AudioBuffer<float> audio;
+
+        //the impulse, plenty of silence after it for the eq to ring out, a power of two long for the fft
+        int impulseLength = 0;
+
+        //the kick, snare and hi hat, which is where the compressor does most of its work
+        int drumsStart = 0, drumsEnd = 0;
+    };
+
+    //the same samples every time on every machine: no files, and juce::Random with a fixed seed for the noise
+    TestSignal makeTestSignal(double sampleRate)
+    {
+        auto seconds = [sampleRate] (double s) { return (int) (s * sampleRate); };
+        constexpr auto twoPi = juce::MathConstants<double>::twoPi;
+
+        TestSignal signal;
+        signal.impulseLength = juce::nextPowerOfTwo(seconds(0.2));
+
+        auto sweepLength = seconds(0.5), gapLength = seconds(0.05);
+        auto kickLength = seconds(0.4), snareLength = seconds(0.3), hatLength = seconds(0.15);
+
+        //long enough after the hat for the silence skip to kick in, so that gets checked too
+        auto tailLength = seconds(0.25);
+
+        auto length = signal.impulseLength + sweepLength + gapLength + kickLength + snareLength + hatLength + tailLength;
+        signal.audio.setSize(1, length);
+        signal.audio.clear();
+
+        auto* data = signal.audio.getWritePointer(0);
+        juce::Random random(0x51a95);
+        auto position = 0;
+
+        //half scale, so the compressor barely notices and this is mostly the eq's impulse response
+        data[position] = 0.5f;
+        position += signal.impulseLength;
+
+        //exponential sweep at -12 dB from 20 Hz to 20 kHz (or as near as the rate allows), with short fades
+        auto startFrequency = 20.0, endFrequency = juce::jmin(20000.0, sampleRate * 0.45);
+        auto sweepSeconds = (double) sweepLength / sampleRate;
+        auto sweepRate = std::log(endFrequency / startFrequency);
+        auto fadeLength = seconds(0.005);
+
+        for (int i = 0; i < sweepLength; ++i)
+        {
+            auto t = (double) i / sampleRate;
+            auto phase = twoPi * startFrequency * sweepSeconds / sweepRate * (std::exp(t / sweepSeconds * sweepRate) - 1.0);
+            auto fade = juce::jmin(1.0, (double) juce::jmin(i, sweepLength - 1 - i) / (double) fadeLength);
+
+            data[position + i] = (float) (0.25 * fade * std::sin(phase));
+        }
+
+        position += sweepLength + gapLength;
+        signal.drumsStart = position;
+
+        //kick: a sine dropping from 150 Hz to 50 Hz, loud enough to hit the compressor hard
+        auto kickPhase = 0.0;
+
+        for (int i = 0; i < kickLength; ++i)
+        {
+            auto t = (double) i / sampleRate;
+            kickPhase += twoPi * (50.0 + 100.0 * std::exp(-t / 0.03)) / sampleRate;
+
+            data[position + i] = (float) (0.9 * std::exp(-t / 0.08) * std::sin(kickPhase));
+        }
+
+        position += kickLength;
+
+        //snare: a 180 Hz body and a noise rattle
+        for (int i = 0; i < snareLength; ++i)
+        {
+            auto t = (double) i / sampleRate;
+            auto body = std::exp(-t / 0.05) * std::sin(twoPi * 180.0 * t);
+            auto rattle = std::exp(-t / 0.06) * (random.nextDouble() * 2.0 - 1.0);
+
+            data[position + i] = (float) (0.35 * body + 0.35 * rattle);
+        }
+
+        position += snareLength;
+
+        //hi hat: differenced noise, which leans it towards the top end
+        auto lastNoise = 0.0;
+
+        for (int i = 0; i < hatLength; ++i)
+        {
+            auto t = (double) i / sampleRate;
+            auto noise = random.nextDouble() * 2.0 - 1.0;
+
+            data[position + i] = (float) (0.2 * std::exp(-t / 0.02) * (noise - lastNoise));
+            lastNoise = noise;
+        }
+
+        position += hatLength;
+        signal.drumsEnd = position;
+
+        return signal;
+    }
+
+    //==============================================================================
+    struct GoldenCase
+    {
+        double sampleRate;
+        int instrument;
+        float slap, gain;
+        bool bypass;
+
+        //what the reference render gets saved as, e.g. 48000_hihat_slap12_gain-12.wav
+        juce::String getFileName() const
+        {
+            auto instrumentName = juce::String(InstrumentProfiles::builtIn[(size_t) instrument].name).removeCharacters(" ").toLowerCase();
+
+            return juce::String((int) sampleRate) + "_" + instrumentName + "_slap" + juce::String((int) slap) + "_gain" + juce::String((int) gain)
+                 + (bypass ? "_bypass" : "") + ".wav";
+        }
+
+        //how far below the reference's peak the biggest difference has to be. bypassed is only the gain going
+        //in and back out, anything driving the compressor hard gets a bit more room for its envelope
+        float getToleranceDecibels() const noexcept
+        {
+            if (bypass)
+                return -130.0f;
+
+            return slap >= 24.0f || gain > 0.0f ? -90.0f : -100.0f;
+        }
+    };
+
+    std::vector<GoldenCase> makeCases()
+    {
+        std::vector<GoldenCase> cases;
+
+        //only the built in instruments, anything from the user's file could be different on every machine
+        for (auto sampleRate : { 44100.0, 48000.0, 96000.0 })
+        {
+            for (int instrument = 0; instrument < InstrumentProfiles::numBuiltIn; ++instrument)
+            {
+                for (auto slap : { -6.0f, 0.0f, 12.0f, 36.0f })
+                    for (auto gain : { -12.0f, 0.0f, 12.0f })
+                        cases.push_back({ sampleRate, instrument, slap, gain, false });
+
+                cases.push_back({ sampleRate, instrument, 12.0f, 0.0f, true });
+            }
+        }
+
+        return cases;
+    }
+
+    //the block sizes the host sends, over and over until the signal runs out
+    const std::vector<int> goldenBlockSizes { 512 };
+    const std::vector<int> smallBlockSizes { 32 };
+    const std::vector<int> largeBlockSizes { 4096 };
+    const std::vector<int> unevenBlockSizes { 1, 7, 32, 100, 4096, 13, 511, 64, 2048, 3 };
+
+    juce::AudioBuffer<float> render(const GoldenCase& goldenCase, const juce::AudioBuffer<float>& input,
+                                    bool useFusedKernel, const std::vector<int>& blockSizes)
+    {
+        SlapsAudioProcessor processor;
+        auto numChannels = input.getNumChannels();
+        auto length = input.getNumSamples();
+
+        if (! setChannelLayout(processor, numChannels))
+        {
+            jassertfalse;
+            return {};
+        }
+
+        RenderSettings settings;
+        settings.useFusedKernel = useFusedKernel;
+        settings.parameters.set("INSTRUMENT", goldenCase.instrument);
+        settings.parameters.set("SLAP", goldenCase.slap);
+        settings.parameters.set("GAIN", goldenCase.gain);
+        settings.parameters.set("BYPASS", goldenCase.bypass ? 1.0f : 0.0f);
+        applyRenderSettings(processor, settings);
+
+        auto maxBlockSize = *std::max_element(blockSizes.begin(), blockSizes.end());
+        processor.setNonRealtime(true);
+        processor.setRateAndBufferSizeDetails(goldenCase.sampleRate, maxBlockSize);
+        processor.prepareToPlay(goldenCase.sampleRate, maxBlockSize);
+
+        //same as a normal render, run the latency's worth of silence past the end and drop it off the front
+        auto latency = processor.getLatencySamples();
+        juce::AudioBuffer<float> padded(numChannels, length + latency);
+        padded.clear();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            padded.copyFrom(channel, 0, input, channel, 0, length);
+
+        juce::MidiBuffer midiMessages;
+
+        for (int position = 0, block = 0; position < padded.getNumSamples(); ++block)
+        {
+            auto numSamples = juce::jmin(blockSizes[(size_t) block % blockSizes.size()], padded.getNumSamples() - position);
+
+            //points at the same channel data, no copying
+            juce::AudioBuffer<float> chunk(padded.getArrayOfWritePointers(), numChannels, position, numSamples);
+            processor.processBlock(chunk, midiMessages);
+
+            position += numSamples;
+        }
+
+        processor.releaseResources();
+
+        juce::AudioBuffer<float> output(numChannels, length);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            output.copyFrom(channel, 0, padded, channel, latency, length);
+
+        return output;
+    }
+
+    //==============================================================================
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        //32 bit wavs are float, so the reference is exactly what came out
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, (unsigned int) audio.getNumChannels(), 32, {}, 0));
+
+        if (writer == nullptr)
+            return false;
+
+        //the writer owns the stream now
+        stream.release();
+
+        return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+
+    bool readWav(const juce::File& file, juce::AudioBuffer<float>& audio)
+    {
+        std::unique_ptr<juce::InputStream> stream(file.createInputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(stream.release(), true));
+
+        if (reader == nullptr)
+            return false;
+
+        audio.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+        return reader->read(&audio, 0, audio.getNumSamples(), 0, true, true);
+    }
+
+    //==============================================================================
+    //the biggest difference anywhere, in dB against full scale (or against the reference's peak if it's given)
+    float getMaxErrorDecibels(const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual, float relativeTo = 1.0f)
+    {
+        auto maxError = 0.0f;
+
+        for (int channel = 0; channel < expected.getNumChannels(); ++channel)
+            for (int i = 0; i < expected.getNumSamples(); ++i)
+                maxError = juce::jmax(maxError, std::abs(expected.getSample(channel, i) - actual.getSample(channel, i)));
+
+        return juce::Decibels::gainToDecibels(maxError / juce::jmax(relativeTo, 1.0e-6f), -400.0f);
+    }
+
+    juce::String describeError(float errorDecibels)
+    {
+        return errorDecibels <= -400.0f ? juce::String("identical") : juce::String(errorDecibels, 1) + " dB";
+    }
+
+    //the impulse's magnitude response, one value per fft bin
+    std::vector<float> getResponseDecibels(const juce::AudioBuffer<float>& audio, int impulseLength)
+    {
+        juce::dsp::FFT fft(juce::roundToInt(std::log2((double) impulseLength)));
+        std::vector<float> data((size_t) impulseLength * 2, 0.0f);
+
+        std::copy(audio.getReadPointer(0), audio.getReadPointer(0) + impulseLength, data.begin());
+        fft.performFrequencyOnlyForwardTransform(data.data());
+
+        std::vector<float> decibels((size_t) impulseLength / 2 + 1);
+
+        for (size_t bin = 0; bin < decibels.size(); ++bin)
+            decibels[bin] = juce::Decibels::gainToDecibels(data[bin], -200.0f);
+
+        return decibels;
+    }
+
+    //what failing cases get to say about what actually moved
+    struct Deltas
+    {
+        float responseDecibels = 0.0f, responseFrequency = 0.0f;
+        float levelDecibels = 0.0f, levelSeconds = 0.0f;
+    };
+
+    Deltas getDeltas(const TestSignal& signal, const juce::AudioBuffer<float>& expected, const juce::AudioBuffer<float>& actual, double sampleRate)
+    {
+        Deltas deltas;
+
+        //the eq, from the impulse. anything 80 dB down from the loudest bin is left out, it's just noise
+        auto expectedResponse = getResponseDecibels(expected, signal.impulseLength);
+        auto actualResponse = getResponseDecibels(actual, signal.impulseLength);
+        auto floor = *std::max_element(expectedResponse.begin(), expectedResponse.end()) - 80.0f;
+        auto binWidth = (float) sampleRate / (float) signal.impulseLength;
+
+        for (size_t bin = 0; bin < expectedResponse.size(); ++bin)
+        {
+            auto frequency = binWidth * (float) bin;
+
+            if (frequency < 20.0f || frequency > juce::jmin(20000.0f, (float) sampleRate * 0.45f) || expectedResponse[bin] < floor)
+                continue;
+
+            auto delta = actualResponse[bin] - expectedResponse[bin];
+
+            if (std::abs(delta) > std::abs(deltas.responseDecibels))
+            {
+                deltas.responseDecibels = delta;
+                deltas.responseFrequency = frequency;
+            }
+        }
+
+        //the compressor, from the drums. the input's the same for both, so the difference in level over each
+        //5 ms is how much the gain reduction moved
+        auto windowLength = juce::jmax(1, (int) (sampleRate * 0.005));
+
+        for (int start = signal.drumsStart; start + windowLength <= signal.drumsEnd; start += windowLength)
+        {
+            auto expectedLevel = juce::Decibels::gainToDecibels(expected.getRMSLevel(0, start, windowLength), -200.0f);
+            auto actualLevel = juce::Decibels::gainToDecibels(actual.getRMSLevel(0, start, windowLength), -200.0f);
+
+            if (expectedLevel < -60.0f)
+                continue;
+
+            if (std::abs(actualLevel - expectedLevel) > std::abs(deltas.levelDecibels))
+            {
+                deltas.levelDecibels = actualLevel - expectedLevel;
+                deltas.levelSeconds = (float) ((start - signal.drumsStart) / sampleRate);
+            }
+        }
+
+        return deltas;
+    }
+
+    //the committed references, Tools/SlapsRender/Golden in whichever checkout this was built or run from
+    juce::File findCommittedGoldenFolder()
+    {
+        auto executable = juce::File::getSpecialLocation(juce::File::currentExecutableFile);
+
+        for (auto start : { juce::File::getCurrentWorkingDirectory(), executable.getParentDirectory() })
+        {
+            for (auto dir = start; ; dir = dir.getParentDirectory())
+            {
+                auto candidate = dir.getChildFile("Tools").getChildFile("SlapsRender").getChildFile("Golden");
+
+                if (candidate.isDirectory())
+                    return candidate;
+
+                if (dir.isRoot() || dir == dir.getParentDirectory())
+                    break;
+            }
+        }
+
+        return {};
+    }
+
+    juce::File getGoldenFolder(const juce::ArgumentList& args, const juce::String& option)
+    {
+        auto path = args.getValueForOption(option);
+
+        if (path.isNotEmpty())
+            return juce::File::getCurrentWorkingDirectory().getChildFile(path);
+
+        return findCommittedGoldenFolder();
+    }
+}
+
+//==============================================================================
+int runMakeGolden(const juce::ArgumentList& args)
+{
+    auto folder = getGoldenFolder(args, "--make-golden");
+
+    if (folder == juce::File())
+    {
+        std::cerr << "couldn't find Tools/SlapsRender/Golden from here, run this from inside the repo or give it a folder" << std::endl;
+        return 1;
+    }
+
+    if (! folder.createDirectory())
+    {
+        std::cerr << "couldn't make " << folder.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    auto cases = makeCases();
+    double lastRate = 0;
+    TestSignal signal;
+
+    //kept prepared at the rate we're on, so every case shares its coefficient banks instead of designing its own
+    std::unique_ptr<SlapsAudioProcessor> bankHolder;
+
+    for (auto& goldenCase : cases)
+    {
+        if (goldenCase.sampleRate != lastRate)
+        {
+            lastRate = goldenCase.sampleRate;
+            signal = makeTestSignal(lastRate);
+
+            bankHolder = std::make_unique<SlapsAudioProcessor>();
+            bankHolder->prepareToPlay(lastRate, goldenBlockSizes[0]);
+        }
+
+        //the staged path is the plain one, stage by stage, so that's the reference
+        auto output = render(goldenCase, signal.audio, false, goldenBlockSizes);
+        auto file = folder.getChildFile(goldenCase.getFileName());
+
+        if (! writeWav(file, output, goldenCase.sampleRate))
+        {
+            std::cerr << "couldn't write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "wrote " << cases.size() << " reference renders to " << folder.getFullPathName() << std::endl;
+    return 0;
+}
+
+int runGoldenCheck(const juce::ArgumentList& args)
+{
+    auto folder = getGoldenFolder(args, "--check-golden");
+
+    if (! folder.isDirectory())
+    {
+        std::cerr << "no reference renders, see Tools/SlapsRender/Golden/README.md for how they're made" << std::endl;
+        return 1;
+    }
+
+    auto overrideTolerance = args.containsOption("--tolerance");
+    auto tolerance = args.getValueForOption("--tolerance").getFloatValue();
+
+    //changing block size isn't meant to change anything. the only thing allowed to is the silence skip,
+    //which starts on a block boundary and only zeroes what was already below -120 dB
+    constexpr auto blockSizeToleranceDecibels = -120.0f;
+
+    auto cases = makeCases();
+    double lastRate = 0;
+    TestSignal signal;
+    std::unique_ptr<SlapsAudioProcessor> bankHolder;
+    auto numFailed = 0;
+
+    for (auto& goldenCase : cases)
+    {
+        if (goldenCase.sampleRate != lastRate)
+        {
+            lastRate = goldenCase.sampleRate;
+            signal = makeTestSignal(lastRate);
+
+            bankHolder = std::make_unique<SlapsAudioProcessor>();
+            bankHolder->prepareToPlay(lastRate, goldenBlockSizes[0]);
+        }
+
+        auto name = goldenCase.getFileName().upToLastOccurrenceOf(".wav", false, false);
+        juce::AudioBuffer<float> expected;
+
+        if (! readWav(folder.getChildFile(goldenCase.getFileName()), expected)
+            || expected.getNumSamples() != signal.audio.getNumSamples() || expected.getNumChannels() != signal.audio.getNumChannels())
+        {
+            std::cout << "FAIL " << name << ": no reference render that matches the test signal, see Golden/README.md" << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        auto caseTolerance = overrideTolerance ? tolerance : goldenCase.getToleranceDecibels();
+        auto peak = expected.getMagnitude(0, expected.getNumSamples());
+        auto ok = true;
+        juce::String report;
+
+        //both paths against the reference
+        for (auto useFusedKernel : { true, false })
+        {
+            auto actual = render(goldenCase, signal.audio, useFusedKernel, goldenBlockSizes);
+            auto error = getMaxErrorDecibels(expected, actual, peak);
+
+            report << (useFusedKernel ? " fused " : ", staged ") << describeError(error);
+
+            if (error > caseTolerance)
+            {
+                auto deltas = getDeltas(signal, expected, actual, goldenCase.sampleRate);
+
+                report << " (response " << juce::String(deltas.responseDecibels, 3) << " dB at " << juce::roundToInt(deltas.responseFrequency) << " Hz, "
+                       << "gain reduction " << juce::String(deltas.levelDecibels, 3) << " dB at " << juce::roundToInt(deltas.levelSeconds * 1000.0f) << " ms into the drums)";
+                ok = false;
+            }
+        }
+
+        //and the fused path at other block sizes against itself at 4096
+        auto large = render(goldenCase, signal.audio, true, largeBlockSizes);
+
+        for (auto* blockSizes : { &smallBlockSizes, &unevenBlockSizes })
+        {
+            auto error = getMaxErrorDecibels(large, render(goldenCase, signal.audio, true, *blockSizes));
+
+            report << (blockSizes == &smallBlockSizes ? ", 32 vs 4096 " : ", uneven vs 4096 ") << describeError(error);
+            ok = ok && error <= blockSizeToleranceDecibels;
+        }
+
+        std::cout << (ok ? "ok   " : "FAIL ") << name << ":" << report << " (tolerance " << caseTolerance << " dB)" << std::endl;
+
+        if (! ok)
+            ++numFailed;
+    }
+
+    std::cout << (numFailed > 0 ? juce::String(numFailed) + " of " + juce::String((int) cases.size()) + " cases failed"
+                                : "all " + juce::String((int) cases.size()) + " cases match")
+              << " against " << folder.getFullPathName() << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    GoldenCheck.h
+
+    SlapsRender --make-golden and --check-golden: what the plugin actually
+    puts out, pinned down so processBlock can be optimised without guessing.
+
+    A fixed test signal (an impulse, a sine sweep and a synthesised kick,
+    snare and hi hat) goes through every built in instrument over a grid of
+    SLAP, GAIN and BYPASS settings at several sample rates. --make-golden
+    renders them all through the staged path and writes them to a folder
+    as float wavs. --check-golden renders them again through the fused
+    kernel and the staged path and compares them with those, each case
+    with its own tolerance, printing how far the frequency response and
+    the gain reduction moved for anything that fails. It also renders
+    every case at 32, at 4096 and at a mix of odd block sizes, and checks
+    they all come out the same.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//both return the exit code for main, non zero if anything failed
+int runMakeGolden(const juce::ArgumentList& args);
+int runGoldenCheck(const juce::ArgumentList& args);
@@ -0,0 +1,326 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    SlapsRender: runs the Slaps dsp over a pile of audio files without a DAW.
+
+        SlapsRender [options] <files or folders...>
+
+        --instrument=<none|kick|snare|hihat>
+        --slap=<dB>
+        --gain=<dB>
+        --bypass
+        --mix=<percent>     how much of the processed signal is in the output, the rest is the dry input (default 100)
+        --state=<file>      a state blob saved from the plugin, applied before the options above
+        --out=<folder>      where the renders go, otherwise they end up next to the input as name_slaps.wav
+        --block=<samples>   how much to process at a time (default 8192)
+        --threads=<n>       how many files to render at once (default one per core)
+        --staged            use the staged processBlock instead of the fused kernel
+        --oversampling=<off|2|4|8>
+        --linear-phase      use the linear phase oversampling filters instead of the economy ones
+        --linear-phase-eq   run the eq as a linear phase FIR instead of the IIR cascade
+        --low-cut=<12|24|36|48>  the low cut's slope in dB/oct (default 12)
+        --morph=<character> run the eq as state variable filters on a blend of the Kick (0), Snare (1) and Hi Hat (2) curves
+        --multiband         split the compressor into low, mid and high at the instrument's crossovers
+        --band-slap=<low,mid,high>  each band's slap offset from --slap, in dB (multiband only)
+
+        SlapsRender --benchmark [--bench-seconds=s] [--bench-blocks=16,64,...] [--bench-channels=1,2,6,12]
+                                [--bench-instances=1,100,...] [--bench-out=file.json] [--staged]
+
+        times processBlock over every block size, sample rate, layout, instrument and bypass setting,
+        then runs lots of instances in an AudioProcessorGraph, and prints the results as JSON
+
+        SlapsRender --bench-state [--bench-instances=1,100,...] [--bench-out=file.json]
+
+        times saving and restoring every instance's state, in the binary format and the old XML one
+
+        SlapsRender --check-compressor [--tolerance=dB]
+
+        checks the Slaps compressor still matches juce::dsp::Compressor at the default settings
+
+        SlapsRender --make-golden[=folder]
+        SlapsRender --check-golden[=folder] [--tolerance=dB]
+
+        renders a fixed test signal through every built in instrument over a grid of settings and
+        rates, and either saves the renders as the reference (in the repo's Tools/SlapsRender/Golden
+        unless you say otherwise, see the README there for when that's allowed) or checks the fused and staged paths still match them, and that the block size doesn't matter
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RenderJob.h"
+#include "Benchmark.h"
+#include "CompressorCheck.h"
+#include "GoldenCheck.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "usage: SlapsRender [--instrument=none|kick|snare|hihat] [--slap=dB] [--gain=dB] [--bypass] [--mix=%]" << std::endl
+                  << "                   [--state=file] [--out=folder] [--block=samples] [--threads=n] [--staged]" << std::endl
+                  << "                   [--oversampling=off|2|4|8] [--linear-phase] [--linear-phase-eq] [--low-cut=12|24|36|48]" << std::endl
+                  << "                   [--morph=0-2] [--multiband] [--band-slap=low,mid,high]" << std::endl
+                  << "                   <files or folders...>" << std::endl
+                  << "       SlapsRender --benchmark [--bench-seconds=s] [--bench-blocks=list] [--bench-channels=list]" << std::endl
+                  << "                   [--bench-instances=list] [--bench-out=file.json] [--staged]" << std::endl
+                  << "       SlapsRender --bench-state [--bench-instances=list] [--bench-out=file.json]" << std::endl
+                  << "       SlapsRender --check-compressor [--tolerance=dB]" << std::endl
+                  << "       SlapsRender --make-golden[=folder]" << std::endl
+                  << "       SlapsRender --check-golden[=folder] [--tolerance=dB]" << std::endl;
+    }
+
+    //"hihat", "Hi Hat" and "3" all find the same choice
+    int findInstrument(const juce::StringArray& choices, const juce::String& name)
+    {
+        if (name.containsOnly("0123456789"))
+            return name.getIntValue();
+
+        auto squash = [] (const juce::String& s) { return s.removeCharacters(" -_").toLowerCase(); };
+
+        for (int i = 0; i < choices.size(); ++i)
+            if (squash(choices[i]) == squash(name))
+                return i;
+
+        return -1;
+    }
+
+    void addAudioFiles(const juce::File& fileOrFolder, const juce::AudioFormatManager& formatManager, juce::Array<juce::File>& files)
+    {
+        auto wildcards = formatManager.getWildcardForAllFormats();
+
+        if (fileOrFolder.isDirectory())
+        {
+            for (const auto& entry : juce::RangedDirectoryIterator(fileOrFolder, true, wildcards, juce::File::findFiles))
+                files.add(entry.getFile());
+        }
+        else if (fileOrFolder.existsAsFile())
+        {
+            files.add(fileOrFolder);
+        }
+        else
+        {
+            std::cerr << "can't find " << fileOrFolder.getFullPathName() << std::endl;
+        }
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    //the processor's parameter state needs a message manager around, even though we never run its loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (args.containsOption("--benchmark"))
+        return runBenchmarks(args);
+
+    if (args.containsOption("--bench-state"))
+        return runStateBenchmark(args);
+
+    if (args.containsOption("--check-compressor"))
+        return runCompressorCheck(args);
+
+    if (args.containsOption("--make-golden"))
+        return runMakeGolden(args);
+
+    if (args.containsOption("--check-golden"))
+        return runGoldenCheck(args);
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    RenderSettings settings;
+    settings.useFusedKernel = ! args.containsOption("--staged");
+
+    if (args.containsOption("--block"))
+        settings.blockSize = juce::jlimit(16, 1 << 16, args.getValueForOption("--block").getIntValue());
+
+    if (args.containsOption("--state"))
+    {
+        juce::File stateFile(juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--state")));
+
+        if (! stateFile.loadFileAsData(settings.state))
+        {
+            std::cerr << "couldn't read the state from " << stateFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.containsOption("--gain"))
+        settings.parameters.set("GAIN", args.getValueForOption("--gain").getFloatValue());
+
+    if (args.containsOption("--slap"))
+        settings.parameters.set("SLAP", args.getValueForOption("--slap").getFloatValue());
+
+    if (args.containsOption("--bypass"))
+        settings.parameters.set("BYPASS", 1.0f);
+
+    if (args.containsOption("--mix"))
+        settings.parameters.set("MIX", juce::jlimit(0.0f, 100.0f, args.getValueForOption("--mix").getFloatValue()));
+
+    if (args.containsOption("--oversampling"))
+    {
+        //the choices go off, 2x, 4x, 8x
+        auto factor = args.getValueForOption("--oversampling").getIntValue();
+        auto index = factor == 2 ? 1 : factor == 4 ? 2 : factor == 8 ? 3 : 0;
+
+        if (index == 0 && factor > 1)
+        {
+            std::cerr << "oversampling can be off, 2, 4 or 8" << std::endl;
+            return 1;
+        }
+
+        settings.parameters.set("OVERSAMPLING", index);
+    }
+
+    if (args.containsOption("--linear-phase"))
+        settings.parameters.set("OVERSAMPLING_MODE", 1);
+
+    if (args.containsOption("--linear-phase-eq"))
+        settings.parameters.set("EQ_MODE", 1);
+
+    if (args.containsOption("--morph"))
+    {
+        auto character = args.getValueForOption("--morph");
+
+        if (character.isEmpty() || ! character.containsOnly("0123456789."))
+        {
+            std::cerr << "--morph wants a character from 0 (kick) to 2 (hi hat)" << std::endl;
+            return 1;
+        }
+
+        settings.parameters.set("EQ_MODE", 2);
+        settings.parameters.set("CHARACTER", juce::jlimit(0.0f, EqShape::maxCharacter, character.getFloatValue()));
+    }
+
+    if (args.containsOption("--low-cut"))
+    {
+        //the choices go 12, 24, 36, 48 dB/oct
+        auto slope = args.getValueForOption("--low-cut").getIntValue();
+
+        if (slope % 12 != 0 || slope < 12 || slope > 48)
+        {
+            std::cerr << "the low cut slope can be 12, 24, 36 or 48" << std::endl;
+            return 1;
+        }
+
+        settings.parameters.set("LOW_CUT_SLOPE", slope / 12 - 1);
+    }
+
+    if (args.containsOption("--multiband"))
+        settings.parameters.set("MULTIBAND", 1.0f);
+
+    if (args.containsOption("--band-slap"))
+    {
+        auto offsets = juce::StringArray::fromTokens(args.getValueForOption("--band-slap"), ",", {});
+
+        if (offsets.size() != 3)
+        {
+            std::cerr << "--band-slap wants three offsets, low,mid,high" << std::endl;
+            return 1;
+        }
+
+        settings.parameters.set("SLAP_LOW", offsets[0].getFloatValue());
+        settings.parameters.set("SLAP_MID", offsets[1].getFloatValue());
+        settings.parameters.set("SLAP_HIGH", offsets[2].getFloatValue());
+    }
+
+    if (args.containsOption("--instrument"))
+    {
+        //ask a processor what the instruments are called, so this never falls out of step with the plugin
+        //leaving out the empty slots INSTRUMENT pads itself out with
+        SlapsAudioProcessor processor;
+        auto& instrumentNames = processor.instrumentProfiles->getNames();
+
+        auto index = findInstrument(instrumentNames, args.getValueForOption("--instrument"));
+
+        if (! juce::isPositiveAndBelow(index, instrumentNames.size()))
+        {
+            std::cerr << "unknown instrument, pick one of: " << instrumentNames.joinIntoString(", ") << std::endl;
+            return 1;
+        }
+
+        settings.parameters.set("INSTRUMENT", index);
+    }
+
+    if (args.containsOption("--out"))
+    {
+        settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--out"));
+
+        if (! settings.outputDirectory.createDirectory())
+        {
+            std::cerr << "couldn't create " << settings.outputDirectory.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    juce::Array<juce::File> files;
+
+    for (auto& arg : args.arguments)
+        if (! arg.isOption())
+            addAudioFiles(arg.resolveAsFile(), formatManager, files);
+
+    if (files.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    //one thread reading ahead, one writing behind, and a pool doing the actual dsp
+    juce::TimeSliceThread readThread("SlapsRender reader"), writeThread("SlapsRender writer");
+    readThread.startThread();
+    writeThread.startThread();
+
+    auto numThreads = args.containsOption("--threads") ? juce::jmax(1, args.getValueForOption("--threads").getIntValue())
+                                                       : juce::SystemStats::getNumCpus();
+
+    juce::ThreadPool pool(numThreads);
+    juce::OwnedArray<RenderJob> jobs;
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto& file : files)
+        pool.addJob(jobs.add(new RenderJob(file, settings, formatManager, readThread, writeThread)), false);
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(10);
+
+    //the writers flush whatever's left when they're deleted, which happens as each job finishes
+    readThread.stopThread(1000);
+    writeThread.stopThread(10000);
+
+    int numFailed = 0;
+    juce::int64 totalSamples = 0;
+
+    for (auto* job : jobs)
+    {
+        if (job->getError().isEmpty())
+        {
+            totalSamples += job->getNumSamplesRendered();
+            std::cout << job->getInputFile().getFileName() << " -> " << job->getOutputFile().getFullPathName()
+                      << " (" << juce::String(job->getSecondsTaken(), 3) << "s)" << std::endl;
+        }
+        else
+        {
+            ++numFailed;
+            std::cerr << job->getInputFile().getFileName() << ": " << job->getError() << std::endl;
+        }
+    }
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    std::cout << jobs.size() - numFailed << " of " << jobs.size() << " files rendered in "
+              << juce::String(seconds, 2) << "s (" << totalSamples << " sample frames)" << std::endl;
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    RenderJob.cpp
+
+  ==============================================================================
+*/
+
+#include "RenderJob.h"
+
+void applyRenderSettings(SlapsAudioProcessor& processor, const RenderSettings& settings)
+{
+    if (settings.state.getSize() > 0)
+        processor.setStateInformation(settings.state.getData(), (int) settings.state.getSize());
+
+    for (auto& parameter : settings.parameters)
+        if (auto* param = processor.apvts.getParameter(parameter.name.toString()))
+            param->setValueNotifyingHost(param->convertTo0to1((float) parameter.value));
+
+    processor.useFusedKernel = settings.useFusedKernel;
+}
+
+bool setChannelLayout(SlapsAudioProcessor& processor, int numChannels)
+{
+    auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+
+    return processor.setBusesLayout(layout);
+}
+
+//==============================================================================
+RenderJob::RenderJob(const juce::File& inputFile, const RenderSettings& renderSettings,
+                     juce::AudioFormatManager& manager,
+                     juce::TimeSliceThread& readerThread, juce::TimeSliceThread& writerThread)
+    : juce::ThreadPoolJob("Render " + inputFile.getFileName()),
+      input(inputFile), settings(renderSettings), formatManager(manager),
+      readThread(readerThread), writeThread(writerThread)
+{
+    //never write over the file we're reading from
+    if (settings.outputDirectory != juce::File() && settings.outputDirectory != input.getParentDirectory())
+        output = settings.outputDirectory.getChildFile(input.getFileName());
+    else
+        output = input.getSiblingFile(input.getFileNameWithoutExtension() + "_slaps" + input.getFileExtension());
+}
+
+juce::ThreadPoolJob::JobStatus RenderJob::runJob()
+{
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    if (! render() && error.isEmpty())
+        error = "stopped before it finished";
+
+    secondsTaken = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    return jobHasFinished;
+}
+
+bool RenderJob::render()
+{
+    std::unique_ptr<juce::AudioFormatReader> fileReader(formatManager.createReaderFor(input));
+
+    if (fileReader == nullptr)
+    {
+        error = "couldn't open it as audio";
+        return false;
+    }
+
+    auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+
+    if (format == nullptr)
+    {
+        error = "don't know how to write " + input.getFileExtension() + " files";
+        return false;
+    }
+
+    auto numChannels = (int) fileReader->numChannels;
+    auto sampleRate = fileReader->sampleRate;
+    auto lengthInSamples = fileReader->lengthInSamples;
+    auto bitsPerSample = (int) fileReader->bitsPerSample;
+    auto metadata = fileReader->metadataValues;
+
+    //every file gets its own processor, so they can all run side by side
+    SlapsAudioProcessor processor;
+
+    if (! setChannelLayout(processor, numChannels))
+    {
+        error = "Slaps doesn't do " + juce::String(numChannels) + " channel audio";
+        return false;
+    }
+
+    applyRenderSettings(processor, settings);
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+    processor.prepareToPlay(sampleRate, settings.blockSize);
+
+    //reads ahead on the background thread so the dsp never waits on the disk, and waits for it if it has to
+    juce::BufferingAudioReader reader(fileReader.release(), readThread, settings.blockSize * 4);
+    reader.setReadTimeout(-1);
+
+    output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(output.createOutputStream());
+
+    if (stream == nullptr)
+    {
+        error = "couldn't write to " + output.getFullPathName();
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                            bitsPerSample, metadata, 0));
+
+    if (writer == nullptr)
+    {
+        error = "couldn't create a writer for " + output.getFileName();
+        return false;
+    }
+
+    //the writer owns the stream now
+    stream.release();
+
+    //and the writes get flushed to disk on the other background thread
+    juce::AudioFormatWriter::ThreadedWriter threadedWriter(writer.release(), writeThread, settings.blockSize * 4);
+
+    juce::AudioBuffer<float> buffer(numChannels, settings.blockSize);
+    juce::MidiBuffer midiMessages;
+
+    //oversampling delays everything, so run that much silence past the end and drop that much from the start
+    auto latency = (juce::int64) processor.getLatencySamples();
+    auto samplesToSkip = latency;
+    std::array<const float*, (size_t) LevelMeters::maxNumChannels> writePointers{};
+
+    for (juce::int64 position = 0; position < lengthInSamples + latency; position += settings.blockSize)
+    {
+        if (shouldExit())
+            return false;
+
+        auto numSamples = (int) juce::jmin((juce::int64) settings.blockSize, lengthInSamples + latency - position);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+
+        //anything past the end of the file comes back as silence
+        reader.read(&buffer, 0, numSamples, position, true, true);
+        processor.processBlock(buffer, midiMessages);
+
+        auto skip = (int) juce::jmin(samplesToSkip, (juce::int64) numSamples);
+        samplesToSkip -= skip;
+
+        if (skip == numSamples)
+            continue;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            writePointers[(size_t) channel] = buffer.getReadPointer(channel, skip);
+
+        //the fifo is only full if the disk is behind, give it a moment
+        while (! threadedWriter.write(writePointers.data(), numSamples - skip))
+            juce::Thread::sleep(1);
+
+        numSamplesRendered += numSamples - skip;
+    }
+
+    processor.releaseResources();
+    return true;
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    RenderJob.h
+
+    Runs one audio file through its own SlapsAudioProcessor on a thread pool.
+    Reading and writing happen on background TimeSliceThreads, so the disk
+    stays busy while the DSP runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+//what every file gets rendered with
+struct RenderSettings
+{
+    //a blob saved from the plugin with getStateInformation, applied first if there is one
+    juce::MemoryBlock state;
+
+    //parameter ID -> value in the parameter's own units (dB for GAIN and SLAP, the index for INSTRUMENT)
+    juce::NamedValueSet parameters;
+
+    juce::File outputDirectory;
+    int blockSize = 8192;
+    bool useFusedKernel = true;
+};
+
+//sets up a fresh processor with the state blob and parameters, call it before prepareToPlay
+void applyRenderSettings(SlapsAudioProcessor& processor, const RenderSettings& settings);
+
+//sets the processor's buses to match a file with this many channels, returns false if Slaps can't do it
+bool setChannelLayout(SlapsAudioProcessor& processor, int numChannels);
+
+//==============================================================================
+class RenderJob  : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(const juce::File& inputFile, const RenderSettings& settings,
+              juce::AudioFormatManager& formatManager,
+              juce::TimeSliceThread& readThread, juce::TimeSliceThread& writeThread);
+
+    JobStatus runJob() override;
+
+    const juce::File& getInputFile() const noexcept { return input; }
+    const juce::File& getOutputFile() const noexcept { return output; }
+
+    //empty if it worked
+    const juce::String& getError() const noexcept { return error; }
+    double getSecondsTaken() const noexcept { return secondsTaken; }
+    juce::int64 getNumSamplesRendered() const noexcept { return numSamplesRendered; }
+
+private:
+    bool render();
+
+    juce::File input, output;
+    const RenderSettings& settings;
+    juce::AudioFormatManager& formatManager;
+    juce::TimeSliceThread& readThread;
+    juce::TimeSliceThread& writeThread;
+
+    juce::String error;
+    double secondsTaken = 0;
+    juce::int64 numSamplesRendered = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderJob)
+};